@@ -0,0 +1,466 @@
+#ifndef ASYNCIO_H
+#define ASYNCIO_H
+
+#include "../ThreadPool.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <atomic>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace ccy
+{
+
+/**
+ * 异步 io 完成时的回调，在线程池的工作线程中执行
+ * @param result 成功时为读写的字节数，失败时为 -errno
+ */
+using AsyncIoCallback = std::function<void(long result)>;
+
+/**
+ * 异步 io 统计信息的快照
+ */
+struct AsyncIoInfo {
+    bool is_uring_ = false;                                         // 是否使用 io_uring，否则使用 io 线程
+    unsigned long submit_num_ = 0;                                  // 提交的请求数量
+    unsigned long finish_num_ = 0;                                  // 完成的请求数量
+    unsigned long submit_call_num_ = 0;                             // io_uring_enter 提交的次数，多个请求可合并为一次
+};
+
+
+/**
+ * 异步文件 io，完成后将回调写入线程池执行，读写期间不占用工作线程
+ * 优先使用 io_uring：提交方写入 SQE，多个并发提交的 SQE 合并为一次 io_uring_enter，由单独的线程收割 CQE
+ * 内核不支持 io_uring 时，退化为固定数量的 io 线程执行 pread / pwrite
+ * 同时处理中的请求数量不超过 queueDepth，超出时提交方等待
+ * @notice 推荐通过 ThreadPool::readAsync() / writeAsync() 使用
+ */
+class AsyncIo {
+public:
+    explicit AsyncIo(ThreadPool* pool) {
+        pool_ = pool;
+    }
+
+    ~AsyncIo() {
+        destroy();
+    }
+
+    /**
+     * 初始化
+     * @param useUring 是否尝试使用 io_uring
+     * @param threadSize 不使用 io_uring 时，io 线程的数量
+     * @param queueDepth 同时处理中的请求数量上限
+     * @return
+     */
+    Status init(bool useUring, int threadSize, int queueDepth) {
+        Status status;
+        if (is_init_) {
+            return status;
+        }
+        RETURN_ERROR_STATUS_BY_CONDITION(threadSize <= 0 || queueDepth <= 0, "async io param cannot less than 1")
+
+        depth_ = (unsigned int)queueDepth;
+        stop_ = false;
+        if (useUring && setupUring()) {
+            threads_.emplace_back(&AsyncIo::reapLoop, this);
+        } else {
+            for (int i = 0; i < threadSize; i++) {
+                threads_.emplace_back(&AsyncIo::ioLoop, this);
+            }
+        }
+        is_init_ = true;
+        return status;
+    }
+
+    /**
+     * 等待处理中的请求全部完成，并停止 io 线程
+     * @return
+     */
+    Status destroy() {
+        Status status;
+        if (!is_init_) {
+            return status;
+        }
+
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            cv_.wait(lk, [this] { return 0 == inflight_; });
+            stop_ = true;
+        }
+        cv_.notify_all();
+        if (is_uring_) {
+            submitNop();        // 唤醒收割线程
+        }
+        for (auto& thd : threads_) {
+            thd.join();
+        }
+        threads_.clear();
+        teardownUring();
+        is_init_ = false;
+        return status;
+    }
+
+    /**
+     * 提交异步读写
+     * @param op ASYNC_IO_READ 或 ASYNC_IO_WRITE
+     * @param fd
+     * @param offset
+     * @param buf 需保持有效，直到请求完成
+     * @param len
+     * @param onFinished 完成回调，在回调返回后 future 才就绪
+     * @return 读写的字节数，失败时为 -errno。回调抛出异常时，future 的 get() 抛出该异常
+     */
+    std::future<long> submit(int op, int fd, long offset, void* buf, size_t len,
+                             AsyncIoCallback onFinished) {
+        std::unique_ptr<Request> req(new Request());
+        req->op_ = op;
+        req->fd_ = fd;
+        req->offset_ = offset;
+        req->buf_ = buf;
+        req->len_ = len;
+        req->on_finished_ = std::move(onFinished);
+        std::future<long> result = req->promise_.get_future();
+
+        std::unique_lock<std::mutex> lk(mutex_);
+        cv_.wait(lk, [this] { return inflight_ < depth_; });
+        inflight_++;
+        submit_num_.fetch_add(1, std::memory_order_relaxed);
+        if (is_uring_) {
+            pending_++;
+            writeSqe(req.release());
+            lk.unlock();
+            flush();
+        } else {
+            requests_.emplace_back(std::move(req));
+            lk.unlock();
+            cv_.notify_all();
+        }
+        return result;
+    }
+
+    /**
+     * 获取统计信息
+     * @param info
+     */
+    void snapshot(AsyncIoInfo& info) const {
+        info.is_uring_ = is_uring_;
+        info.submit_num_ = submit_num_.load(std::memory_order_relaxed);
+        info.finish_num_ = finish_num_.load(std::memory_order_relaxed);
+        info.submit_call_num_ = submit_call_num_.load(std::memory_order_relaxed);
+    }
+
+    NO_ALLOWED_COPY(AsyncIo)
+
+protected:
+    struct Request {
+        int op_ = ASYNC_IO_READ;
+        int fd_ = -1;
+        long offset_ = 0;
+        void* buf_ = nullptr;
+        size_t len_ = 0;
+        std::promise<long> promise_;
+        AsyncIoCallback on_finished_;
+        iovec iov_ {};                                              // io_uring 读写使用的缓冲区描述
+    };
+
+    /**
+     * 请求完成，将回调写入线程池执行
+     * 回调中的异常通过 future 交给调用方，避免抛到工作线程中导致进程退出
+     * @param req
+     * @param result
+     */
+    void complete(Request* req, long result) {
+        Task task([holder = std::unique_ptr<Request>(req), result] {
+            try {
+                if (holder->on_finished_) {
+                    holder->on_finished_(result);
+                }
+            } catch (...) {
+                holder->promise_.set_exception(std::current_exception());
+                return;
+            }
+            holder->promise_.set_value(result);
+        });
+        pool_->pushCompletionTask(std::move(task));
+        finish_num_.fetch_add(1, std::memory_order_relaxed);
+
+        {
+            LOCK_GUARD lk(mutex_);
+            inflight_--;
+        }
+        cv_.notify_all();
+    }
+
+    /**
+     * io 线程执行函数，不支持 io_uring 时使用
+     */
+    void ioLoop() {
+        while (true) {
+            std::unique_ptr<Request> req;
+            {
+                std::unique_lock<std::mutex> lk(mutex_);
+                cv_.wait(lk, [this] { return stop_ || !requests_.empty(); });
+                if (requests_.empty()) {
+                    return;
+                }
+                req = std::move(requests_.front());
+                requests_.pop_front();
+            }
+
+            ssize_t ret = (ASYNC_IO_READ == req->op_)
+                          ? pread(req->fd_, req->buf_, req->len_, req->offset_)
+                          : pwrite(req->fd_, req->buf_, req->len_, req->offset_);
+            complete(req.release(), ret < 0 ? -(long)errno : (long)ret);
+        }
+    }
+
+    /**
+     * 创建 io_uring，并映射提交队列、完成队列和 SQE 数组
+     * @return 内核不支持时返回 false
+     */
+    bool setupUring() {
+        io_uring_params params {};
+        ring_fd_ = (int)syscall(__NR_io_uring_setup, depth_, &params);
+        if (ring_fd_ < 0) {
+            return false;
+        }
+
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP);
+        if (single) {
+            sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+        }
+        sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ring_fd_, IORING_OFF_SQ_RING);
+        cq_ptr_ = single ? sq_ptr_ : mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                          ring_fd_, IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = (io_uring_sqe*)mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                    ring_fd_, IORING_OFF_SQES);
+        if (MAP_FAILED == sq_ptr_ || MAP_FAILED == cq_ptr_ || MAP_FAILED == (void*)sqes_) {
+            teardownUring();
+            return false;
+        }
+
+        auto* sq = (char*)sq_ptr_;
+        sq_head_ = (unsigned int*)(sq + params.sq_off.head);
+        sq_tail_ = (unsigned int*)(sq + params.sq_off.tail);
+        sq_mask_ = *(unsigned int*)(sq + params.sq_off.ring_mask);
+        sq_entries_ = params.sq_entries;
+        sq_array_ = (unsigned int*)(sq + params.sq_off.array);
+        auto* cq = (char*)cq_ptr_;
+        cq_head_ = (unsigned int*)(cq + params.cq_off.head);
+        cq_tail_ = (unsigned int*)(cq + params.cq_off.tail);
+        cq_mask_ = *(unsigned int*)(cq + params.cq_off.ring_mask);
+        cqes_ = (io_uring_cqe*)(cq + params.cq_off.cqes);
+        depth_ = std::min(depth_, sq_entries_);         // 处理中的请求不超过 SQ 的容量，CQ 不会溢出
+        is_uring_ = true;
+        return true;
+    }
+
+    void teardownUring() {
+        if (nullptr != sqes_ && MAP_FAILED != (void*)sqes_) {
+            munmap(sqes_, sqes_size_);
+        }
+        if (nullptr != cq_ptr_ && MAP_FAILED != cq_ptr_ && cq_ptr_ != sq_ptr_) {
+            munmap(cq_ptr_, cq_size_);
+        }
+        if (nullptr != sq_ptr_ && MAP_FAILED != sq_ptr_) {
+            munmap(sq_ptr_, sq_size_);
+        }
+        sqes_ = nullptr;
+        cq_ptr_ = sq_ptr_ = nullptr;
+        if (ring_fd_ >= 0) {
+            close(ring_fd_);
+            ring_fd_ = -1;
+        }
+        is_uring_ = false;
+    }
+
+    /**
+     * 写入一个 SQE，尚未提交给内核
+     * @param req 为空时，写入 NOP
+     * @notice 调用方需持有 mutex_
+     */
+    void writeSqe(Request* req) {
+        unsigned int tail = *sq_tail_;
+        unsigned int index = tail & sq_mask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        memset(sqe, 0, sizeof(io_uring_sqe));
+        if (nullptr == req) {
+            sqe->opcode = IORING_OP_NOP;
+        } else {
+            // IORING_OP_READ / WRITE 需要 5.6 及以上的内核，READV / WRITEV 自 5.1 起可用，与 io_uring 本身一致
+            req->iov_.iov_base = req->buf_;
+            req->iov_.iov_len = req->len_;
+            sqe->opcode = (ASYNC_IO_READ == req->op_) ? IORING_OP_READV : IORING_OP_WRITEV;
+            sqe->fd = req->fd_;
+            sqe->off = (unsigned long long)req->offset_;
+            sqe->addr = (unsigned long long)(uintptr_t)&req->iov_;
+            sqe->len = 1;
+        }
+        sqe->user_data = (unsigned long long)(uintptr_t)req;
+        sq_array_[index] = index;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * 将已写入的 SQE 提交给内核。并发提交时，由抢到锁的一方一次性提交所有 SQE
+     */
+    void flush() {
+        std::unique_lock<std::mutex> lk(enter_mutex_, std::try_to_lock);
+        if (!lk.owns_lock()) {
+            return;         // 持锁方在 io_uring_enter 返回后会再次检查
+        }
+        while (true) {
+            unsigned int num = 0;
+            {
+                LOCK_GUARD guard(mutex_);
+                num = pending_;
+                pending_ = 0;
+            }
+            if (0 == num) {
+                break;
+            }
+            while (num > 0) {
+                int ret = (int)syscall(__NR_io_uring_enter, ring_fd_, num, 0, 0, nullptr, 0);
+                if (ret < 0 && EINTR != errno && EAGAIN != errno && EBUSY != errno) {
+                    failUnsubmitted(-(long)errno);
+                    return;         // 不再重试，避免错误持续时反复提交；之后的提交会重新尝试
+                }
+                num -= ret > 0 ? (unsigned int)ret : 0;
+            }
+            submit_call_num_.fetch_add(1, std::memory_order_relaxed);
+        }
+        lk.unlock();
+
+        // 释放锁与其他提交方放弃之间存在窗口，再检查一次
+        bool left = false;
+        {
+            LOCK_GUARD guard(mutex_);
+            left = (pending_ > 0);
+        }
+        if (left) {
+            flush();
+        }
+    }
+
+    /**
+     * io_uring_enter 出错时，内核尚未取走的 SQE 对应的请求全部以 result 失败，保证 future 就绪、inflight_ 归零
+     * 这些 SQE 仍留在环中，改写为不关联请求的 NOP，之后被提交时直接忽略
+     * @param result -errno
+     * @notice 调用方需持有 enter_mutex_，此时内核不会并发读取 SQ
+     */
+    void failUnsubmitted(long result) {
+        std::vector<Request*> failed;
+        {
+            LOCK_GUARD guard(mutex_);
+            unsigned int head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+            unsigned int tail = *sq_tail_;
+            for (unsigned int i = head; i != tail; i++) {
+                io_uring_sqe* sqe = &sqes_[i & sq_mask_];
+                auto* req = (Request*)(uintptr_t)sqe->user_data;
+                if (nullptr != req) {
+                    failed.push_back(req);
+                }
+                memset(sqe, 0, sizeof(io_uring_sqe));
+                sqe->opcode = IORING_OP_NOP;
+            }
+            pending_ = tail - head;
+        }
+        for (auto* req : failed) {
+            complete(req, result);
+        }
+    }
+
+    void submitNop() {
+        {
+            LOCK_GUARD lk(mutex_);
+            pending_++;
+            writeSqe(nullptr);
+        }
+        flush();
+    }
+
+    /**
+     * 收割线程执行函数，阻塞等待 CQE，并将完成的请求分发到线程池
+     */
+    void reapLoop() {
+        while (true) {
+            unsigned int head = *cq_head_;
+            unsigned int tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            if (head == tail) {
+                {
+                    LOCK_GUARD lk(mutex_);
+                    if (stop_ && 0 == inflight_) {
+                        return;
+                    }
+                }
+                syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                continue;
+            }
+
+            for (; head != tail; head++) {
+                io_uring_cqe* cqe = &cqes_[head & cq_mask_];
+                auto* req = (Request*)(uintptr_t)cqe->user_data;
+                long result = cqe->res;
+                if (nullptr != req) {
+                    complete(req, result);
+                }
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        }
+    }
+
+private:
+    ThreadPool* pool_ = nullptr;
+    bool is_init_ = false;
+    bool is_uring_ = false;
+    bool stop_ = false;                                             // 修改时需持有 mutex_
+    unsigned int depth_ = 0;                                        // 处理中的请求数量上限
+    unsigned int inflight_ = 0;                                     // 已提交、尚未完成的请求数量
+    unsigned int pending_ = 0;                                      // 已写入 SQE、尚未提交给内核的数量
+    std::mutex mutex_;                                              // 保护请求计数、io 线程的队列、SQ 的写入
+    std::mutex enter_mutex_;                                        // 同一时刻仅有一个提交方调用 io_uring_enter
+    std::condition_variable cv_;
+    std::deque<std::unique_ptr<Request>> requests_;                 // io 线程模式下，待执行的请求
+    std::vector<std::thread> threads_;                              // io 线程，或 io_uring 的收割线程
+
+    int ring_fd_ = -1;
+    void* sq_ptr_ = nullptr;
+    void* cq_ptr_ = nullptr;
+    size_t sq_size_ = 0;
+    size_t cq_size_ = 0;
+    size_t sqes_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned int* sq_head_ = nullptr;
+    unsigned int* sq_tail_ = nullptr;
+    unsigned int* sq_array_ = nullptr;
+    unsigned int sq_mask_ = 0;
+    unsigned int sq_entries_ = 0;
+    unsigned int* cq_head_ = nullptr;
+    unsigned int* cq_tail_ = nullptr;
+    unsigned int cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    std::atomic<unsigned long> submit_num_ {0};
+    std::atomic<unsigned long> finish_num_ {0};
+    std::atomic<unsigned long> submit_call_num_ {0};
+};
+
+}
+
+#endif
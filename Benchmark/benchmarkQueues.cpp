@@ -0,0 +1,423 @@
+#include <benchmark/benchmark.h>
+#include "../ThreadPool.h"
+#include <pthread.h>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <algorithm>
+#include <iostream>
+using namespace ccy;
+
+/**
+ * 各个队列的独立测试，与线程池的调度逻辑无关
+ * 用法：./benchmarkQueues [--producers=N] [--consumers=N] [--payload=8|64|512] [--items=N] [--batch=N] [--pin]
+ *      其余参数透传给 google benchmark
+ * @notice LockFreeRingBufferQueue 仅支持单生产者、单消费者，固定按 1:1 运行
+ */
+
+struct QueueBenchOption {
+    int producers_ = 2;
+    int consumers_ = 2;
+    int payload_ = 64;
+    long items_ = 100000;             // 每个生产者写入的数量
+    int batch_ = 8;                   // 批量接口一次处理的数量
+    bool pin_ = false;                // 是否绑定cpu
+};
+
+static QueueBenchOption g_option;
+static const long LATENCY_SAMPLE_SPAN = 64;          // 每隔多少个元素，采样一次延迟
+static const unsigned int RING_CAPACITY = 1024;
+
+static long nowNs() {
+    return (long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * 固定大小的负载，头部8字节写入入队时间（为0表示不采样）
+ * @tparam SIZE
+ */
+template<int SIZE>
+struct Payload {
+    static_assert(SIZE >= (int)sizeof(long), "payload is too small");
+
+    explicit Payload(long ts = 0) {
+        std::memcpy(data_, &ts, sizeof(long));
+    }
+
+    /** AtomicPriorityQueue 通过 (value, priority) 构造元素 */
+    Payload(Payload&& payload, int) : Payload(std::move(payload)) {}
+
+    Payload(Payload&&) = default;
+    Payload(const Payload&) = default;
+    Payload& operator=(Payload&&) = default;
+    Payload& operator=(const Payload&) = default;
+
+    long timestamp() const {
+        long ts = 0;
+        std::memcpy(&ts, data_, sizeof(long));
+        return ts;
+    }
+
+    char data_[SIZE] = {0};
+};
+
+template<int SIZE>
+static Payload<SIZE> makePayload(long seq) {
+    return Payload<SIZE>(0 == seq % LATENCY_SAMPLE_SPAN ? nowNs() : 0);
+}
+
+static void pinThread(int index) {
+    if (!g_option.pin_ || CPU_NUM <= 0) {
+        return;
+    }
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(index % CPU_NUM, &mask);
+    pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+}
+
+/**
+ * 单个消费者的统计信息
+ */
+struct ConsumerRecord {
+    long pop_fail_ = 0;
+    std::vector<long> samples_;
+
+    template<class P>
+    int record(const P& payload) {
+        long ts = payload.timestamp();
+        if (0 != ts) {
+            samples_.emplace_back(nowNs() - ts);
+        }
+        return 1;
+    }
+};
+
+/**
+ * 多轮执行的累计结果
+ */
+struct QueueRunResult {
+    long items_ = 0;
+    long push_fail_ = 0;
+    long pop_fail_ = 0;
+    unsigned long try_lock_num_ = 0;
+    unsigned long try_lock_fail_num_ = 0;
+    std::vector<long> samples_;
+
+    template<class Q>
+    void collectLock(const Q& queue) {
+#ifdef _ENABLE_QUEUE_PROFILE_
+        try_lock_num_ += queue.getTryLockNum();
+        try_lock_fail_num_ += queue.getTryLockFailNum();
+#endif
+    }
+};
+
+/**
+ * 通用的多生产者、多消费者驱动，返回本轮耗时（s）
+ * push(seq, num) 一次写入 [seq, seq + num) 的元素，返回 false 表示写入失败，需要重试
+ * pop(record) 返回本次弹出的数量，0 表示失败
+ */
+template<class PushFunc, class PopFunc>
+static double runQueue(int producers, int consumers, int pushBatch,
+                       PushFunc& push, PopFunc& pop, QueueRunResult& result) {
+    const long total = producers * g_option.items_;
+    std::atomic<bool> go {false};
+    std::atomic<long> consumed {0};
+    std::atomic<long> pushFail {0};
+    std::vector<ConsumerRecord> records(consumers);
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            pinThread(p);
+            while (!go.load(std::memory_order_acquire)) {}
+            long fail = 0;
+            for (long seq = 0; seq < g_option.items_; seq += pushBatch) {
+                int num = (int)std::min<long>(pushBatch, g_option.items_ - seq);
+                while (!push(seq, num)) {
+                    fail++;
+                    std::this_thread::yield();
+                }
+            }
+            pushFail.fetch_add(fail, std::memory_order_relaxed);
+        });
+    }
+
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&, c] {
+            pinThread(producers + c);
+            while (!go.load(std::memory_order_acquire)) {}
+            auto& record = records[c];
+            while (consumed.load(std::memory_order_relaxed) < total) {
+                int num = pop(record);
+                if (num > 0) {
+                    consumed.fetch_add(num, std::memory_order_relaxed);
+                } else {
+                    record.pop_fail_++;
+                }
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& thd : threads) {
+        thd.join();
+    }
+    auto span = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    result.items_ += total;
+    result.push_fail_ += pushFail.load();
+    for (auto& record : records) {
+        result.pop_fail_ += record.pop_fail_;
+        result.samples_.insert(result.samples_.end(), record.samples_.begin(), record.samples_.end());
+    }
+    return span;
+}
+
+/**
+ * 汇总吞吐、延迟以及 try_lock 失败率
+ */
+static void finishQueue(benchmark::State& state, QueueRunResult& result) {
+    state.SetItemsProcessed(result.items_);
+    state.counters["push_fail/item"] = result.items_ > 0 ? (double)result.push_fail_ / (double)result.items_ : 0.0;
+    state.counters["pop_fail/item"] = result.items_ > 0 ? (double)result.pop_fail_ / (double)result.items_ : 0.0;
+    auto& samples = result.samples_;
+    if (!samples.empty()) {
+        std::sort(samples.begin(), samples.end());
+        auto pick = [&samples](double p) {
+            return (double)samples[(size_t)(p * (double)(samples.size() - 1))];
+        };
+        state.counters["p50_ns"] = pick(0.50);
+        state.counters["p99_ns"] = pick(0.99);
+        state.counters["p999_ns"] = pick(0.999);
+    }
+    if (result.try_lock_num_ > 0) {
+        state.counters["trylock_fail_rate"] = (double)result.try_lock_fail_num_ / (double)result.try_lock_num_;
+    }
+}
+
+
+// AtomicQueue：push / tryPop，range(0) 为批量弹出数量
+template<int SIZE>
+static void BM_AtomicQueue(benchmark::State& state) {
+    const int batch = (int)state.range(0);
+    QueueRunResult result;
+    for (auto _ : state) {
+        AtomicQueue<Payload<SIZE>> queue;
+        auto push = [&queue](long seq, int) {
+            queue.push(makePayload<SIZE>(seq));
+            return true;
+        };
+        auto pop = [&queue, batch](ConsumerRecord& record) -> int {
+            if (batch <= 1) {
+                Payload<SIZE> value;
+                return queue.tryPop(value) ? record.record(value) : 0;
+            }
+            std::vector<Payload<SIZE>> values;
+            values.reserve(batch);
+            queue.tryPop(values, batch);
+            for (const auto& value : values) {
+                record.record(value);
+            }
+            return (int)values.size();
+        };
+        state.SetIterationTime(runQueue(g_option.producers_, g_option.consumers_, 1, push, pop, result));
+        result.collectLock(queue);
+    }
+    finishQueue(state, result);
+}
+
+
+// AtomicPriorityQueue：随机优先级 push / tryPop
+template<int SIZE>
+static void BM_AtomicPriorityQueue(benchmark::State& state) {
+    const int batch = (int)state.range(0);
+    QueueRunResult result;
+    for (auto _ : state) {
+        AtomicPriorityQueue<Payload<SIZE>> queue;
+        auto push = [&queue](long seq, int) {
+            queue.push(makePayload<SIZE>(seq), (int)(seq * 7919 % 201) - 100);
+            return true;
+        };
+        auto pop = [&queue, batch](ConsumerRecord& record) -> int {
+            if (batch <= 1) {
+                Payload<SIZE> value;
+                return queue.tryPop(value) ? record.record(value) : 0;
+            }
+            std::vector<Payload<SIZE>> values;
+            values.reserve(batch);
+            queue.tryPop(values, batch);
+            for (const auto& value : values) {
+                record.record(value);
+            }
+            return (int)values.size();
+        };
+        state.SetIterationTime(runQueue(g_option.producers_, g_option.consumers_, 1, push, pop, result));
+        result.collectLock(queue);
+    }
+    finishQueue(state, result);
+}
+
+
+// AtomicRingBufferQueue：满时等待写入，空时等待弹出
+template<int SIZE>
+static void BM_AtomicRingBufferQueue(benchmark::State& state) {
+    QueueRunResult result;
+    for (auto _ : state) {
+        AtomicRingBufferQueue<Payload<SIZE>, RING_CAPACITY> queue;
+        auto push = [&queue](long seq, int) {
+            queue.push(makePayload<SIZE>(seq), RingBufferPushStrategy::WAIT);
+            return true;
+        };
+        auto pop = [&queue](ConsumerRecord& record) -> int {
+            Payload<SIZE> value;
+            return queue.waitPopWithTimeout(value, 1).isOK() ? record.record(value) : 0;
+        };
+        state.SetIterationTime(runQueue(g_option.producers_, g_option.consumers_, 1, push, pop, result));
+    }
+    finishQueue(state, result);
+}
+
+
+// LockFreeRingBufferQueue：单生产者、单消费者
+template<int SIZE>
+static void BM_LockFreeRingBufferQueue(benchmark::State& state) {
+    QueueRunResult result;
+    for (auto _ : state) {
+        LockFreeRingBufferQueue<Payload<SIZE>, (int)RING_CAPACITY> queue;
+        auto push = [&queue](long seq, int) {
+            queue.push(makePayload<SIZE>(seq));
+            return true;
+        };
+        auto pop = [&queue](ConsumerRecord& record) -> int {
+            Payload<SIZE> value;
+            return queue.tryPop(value) ? record.record(value) : 0;
+        };
+        state.SetIterationTime(runQueue(1, 1, 1, push, pop, result));
+    }
+    finishQueue(state, result);
+}
+
+
+/**
+ * WorkStealingQueue：生产者 tryPush，消费者从头部 tryPop 或从尾部 trySteal
+ * range(0) 为批量大小，range(1) 为 1 时表示 steal
+ */
+template<int SIZE>
+static void BM_WorkStealingQueue(benchmark::State& state) {
+    const int batch = (int)state.range(0);
+    const bool steal = (1 == state.range(1));
+    QueueRunResult result;
+    for (auto _ : state) {
+        WorkStealingQueue<Payload<SIZE>> queue;
+        auto push = [&queue](long seq, int num) {
+            if (1 == num) {
+                return queue.tryPush(makePayload<SIZE>(seq));
+            }
+            std::vector<Payload<SIZE>> values;
+            values.reserve(num);
+            for (int i = 0; i < num; i++) {
+                values.emplace_back(makePayload<SIZE>(seq + i));
+            }
+            return queue.tryPush(values);
+        };
+        auto pop = [&queue, batch, steal](ConsumerRecord& record) -> int {
+            if (batch <= 1) {
+                Payload<SIZE> value;
+                bool result = steal ? queue.trySteal(value) : queue.tryPop(value);
+                return result ? record.record(value) : 0;
+            }
+            std::vector<Payload<SIZE>> values;
+            values.reserve(batch);
+            steal ? queue.trySteal(values, batch) : queue.tryPop(values, batch);
+            for (const auto& value : values) {
+                record.record(value);
+            }
+            return (int)values.size();
+        };
+        state.SetIterationTime(runQueue(g_option.producers_, g_option.consumers_, batch, push, pop, result));
+        result.collectLock(queue);
+    }
+    finishQueue(state, result);
+}
+
+
+template<int SIZE>
+static void registerQueues() {
+    const std::string suffix = "/payload:" + std::to_string(SIZE)
+            + "/p:" + std::to_string(g_option.producers_)
+            + "/c:" + std::to_string(g_option.consumers_);
+    auto config = [](benchmark::internal::Benchmark* bm) {
+        bm->UseManualTime()->Unit(benchmark::kMillisecond);
+    };
+
+    config(benchmark::RegisterBenchmark(("AtomicQueue" + suffix).c_str(), BM_AtomicQueue<SIZE>)
+            ->ArgName("batch")->Arg(1)->Arg(g_option.batch_));
+    config(benchmark::RegisterBenchmark(("AtomicPriorityQueue" + suffix).c_str(), BM_AtomicPriorityQueue<SIZE>)
+            ->ArgName("batch")->Arg(1)->Arg(g_option.batch_));
+    config(benchmark::RegisterBenchmark(("AtomicRingBufferQueue" + suffix).c_str(), BM_AtomicRingBufferQueue<SIZE>));
+    config(benchmark::RegisterBenchmark(("LockFreeRingBufferQueue/payload:" + std::to_string(SIZE) + "/p:1/c:1").c_str(),
+                                        BM_LockFreeRingBufferQueue<SIZE>));
+    config(benchmark::RegisterBenchmark(("WorkStealingQueue" + suffix).c_str(), BM_WorkStealingQueue<SIZE>)
+            ->ArgNames({"batch", "steal"})
+            ->Args({1, 0})->Args({g_option.batch_, 0})
+            ->Args({1, 1})->Args({g_option.batch_, 1}));
+}
+
+/**
+ * 解析本测试自定义的参数，并从 argv 中移除
+ */
+static bool parseOption(int& argc, char** argv) {
+    int remaining = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&arg]() { return arg.substr(arg.find('=') + 1); };
+        if (0 == arg.find("--producers=")) {
+            g_option.producers_ = std::max(1, std::stoi(value()));
+        } else if (0 == arg.find("--consumers=")) {
+            g_option.consumers_ = std::max(1, std::stoi(value()));
+        } else if (0 == arg.find("--payload=")) {
+            g_option.payload_ = std::stoi(value());
+        } else if (0 == arg.find("--items=")) {
+            g_option.items_ = std::max(1L, std::stol(value()));
+        } else if (0 == arg.find("--batch=")) {
+            g_option.batch_ = std::max(2, std::stoi(value()));
+        } else if (arg == "--pin") {
+            g_option.pin_ = true;
+        } else {
+            argv[remaining++] = argv[i];
+        }
+    }
+    argc = remaining;
+
+    if (8 != g_option.payload_ && 64 != g_option.payload_ && 512 != g_option.payload_) {
+        std::cout << "payload only support 8, 64 or 512 bytes" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (!parseOption(argc, argv)) {
+        return 1;
+    }
+
+    switch (g_option.payload_) {
+        case 8: registerQueues<8>(); break;
+        case 512: registerQueues<512>(); break;
+        default: registerQueues<64>(); break;
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,1494 @@
+#include <benchmark/benchmark.h>
+#include "../ThreadPoolInclude.h"
+#include <future>
+#include <random>
+#include <chrono>
+#include <ctime>
+#include <cstdlib>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <memory_resource>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace ccy;
+
+/**
+ * 综合测试集：吞吐、提交到开始执行的延迟、fork-join、负载倾斜、生产者扩展、空闲cpu消耗
+ * 推荐运行方式：
+ * ./benchmarkSuite --benchmark_out=suite.json --benchmark_out_format=json
+ * python3 ../compare_baseline.py suite.json
+ */
+
+static const int SUITE_FIB_CUTOFF = 16;                   // fib 串行计算的阈值
+static const int SUITE_SORT_CUTOFF = 4096;                // quicksort 串行排序的阈值
+
+/**
+ * 根据线程数，生成仅包含主线程的线程池
+ * @param threads
+ * @param histogram 是否开启延迟直方图
+ * @param trace 是否开启调度事件记录
+ * @return
+ */
+static std::unique_ptr<ThreadPool> makePool(int threads, bool histogram = false, bool trace = false) {
+    ThreadPoolConfig config;
+    config.default_thread_size_ = threads;
+    config.secondary_thread_size_ = 0;
+    config.max_thread_size_ = threads;     // 默认策略下，所有任务均进入主线程的本地队列
+    config.latency_histogram_enable_ = histogram;
+    config.trace_enable_ = trace;
+    return std::unique_ptr<ThreadPool>(new ThreadPool(true, config));
+}
+
+/**
+ * 等待一组任务全部完成，不依赖 future
+ */
+class SuiteLatch {
+public:
+    explicit SuiteLatch(long count) : count_(count) {}
+
+    void add(long count) {
+        count_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void countDown() {
+        if (1 == count_.fetch_sub(1, std::memory_order_acq_rel)) {
+            // 在锁内设置完成标记，保证 wait() 返回（latch 可能随之析构）时，这里已经不再访问成员
+            LOCK_GUARD lk(mutex_);
+            done_ = true;
+            cv_.notify_all();
+        }
+    }
+
+    void wait() {
+        UNIQUE_LOCK lk(mutex_);
+        cv_.wait(lk, [this] { return done_; });
+    }
+
+private:
+    std::atomic<long> count_;
+    bool done_ = false;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+static long nowNs() {
+    return (long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double cpuSeconds() {
+    return (double)std::clock() / CLOCKS_PER_SEC;
+}
+
+/**
+ * 将延迟样本的分位数写入 counters，单位为us
+ * @param state
+ * @param samples
+ */
+static void reportLatency(benchmark::State& state, std::vector<long>& samples) {
+    if (samples.empty()) {
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto pick = [&samples](double p) {
+        auto pos = (size_t)(p * (double)(samples.size() - 1));
+        return (double)samples[pos] / 1000.0;
+    };
+    state.counters["p50_us"] = pick(0.50);
+    state.counters["p99_us"] = pick(0.99);
+    state.counters["p999_us"] = pick(0.999);
+}
+
+/**
+ * 写入吞吐与单任务cpu耗时
+ * @param state
+ * @param tasks
+ * @param cpuCost 进程整体cpu耗时，单位为s
+ */
+static void reportThroughput(benchmark::State& state, long tasks, double cpuCost) {
+    state.SetItemsProcessed(tasks);
+    state.counters["tasks/s"] = benchmark::Counter((double)tasks, benchmark::Counter::kIsRate);
+    state.counters["cpu_ns/task"] = tasks > 0 ? cpuCost * 1e9 / (double)tasks : 0.0;
+}
+
+/**
+ * 写入平均每个任务对应的成功窃取次数
+ * @param state
+ * @param pool
+ * @param stealBefore 测试开始前的窃取次数
+ * @param tasks
+ */
+static void reportSteals(benchmark::State& state, ThreadPool* pool, unsigned long stealBefore, long tasks) {
+    auto steals = pool->getStats().total().steal_num_ - stealBefore;
+    state.counters["steals/task"] = tasks > 0 ? (double)steals / (double)tasks : 0.0;
+}
+
+
+// 空任务吞吐
+static void BM_Throughput(benchmark::State& state) {
+    auto pool = makePool((int)state.range(0));
+    const long num = state.range(1);
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        SuiteLatch latch(num);
+        for (long i = 0; i < num; i++) {
+            pool->commit([&latch] { latch.countDown(); });
+        }
+        latch.wait();
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    state.counters["wakeups/task"] = (double)pool->getStats().wakeup_num_ / (double)std::max(total, 1L);
+}
+
+
+// 开启延迟直方图后的空任务吞吐，并输出线程池内部统计的排队耗时
+static void BM_ThroughputWithHistogram(benchmark::State& state) {
+    auto pool = makePool((int)state.range(0), true);
+    const long num = state.range(1);
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        SuiteLatch latch(num);
+        for (long i = 0; i < num; i++) {
+            pool->commit([&latch] { latch.countDown(); });
+        }
+        latch.wait();
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+
+    auto wait = pool->getLatency().totalWait();
+    state.counters["p50_us"] = (double)wait.percentile(0.50) / 1000.0;
+    state.counters["p99_us"] = (double)wait.percentile(0.99) / 1000.0;
+    state.counters["p999_us"] = (double)wait.percentile(0.999) / 1000.0;
+}
+
+
+// 开启调度事件记录后的空任务吞吐，用于评估记录的开销。设置 SUITE_TRACE_PATH 环境变量时导出最后一轮的事件
+static void BM_ThroughputWithTrace(benchmark::State& state) {
+    auto pool = makePool((int)state.range(0), false, true);
+    const long num = state.range(1);
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        SuiteLatch latch(num);
+        for (long i = 0; i < num; i++) {
+            pool->commit([&latch] { latch.countDown(); });
+        }
+        latch.wait();
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+
+    const char* path = std::getenv("SUITE_TRACE_PATH");
+    if (nullptr != path) {
+        pool->dumpTrace(path);
+    }
+}
+
+
+// 突发提交时，从 commit 到开始执行的延迟
+static void BM_BurstLatency(benchmark::State& state) {
+    auto pool = makePool((int)state.range(0));
+    const long num = state.range(1);
+    std::vector<long> samples;
+    samples.reserve(num * 16);
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        std::vector<long> starts(num, 0);
+        SuiteLatch latch(num);
+        for (long i = 0; i < num; i++) {
+            long submit = nowNs();
+            pool->commit([&starts, &latch, submit, i] {
+                starts[i] = nowNs() - submit;
+                latch.countDown();
+            });
+        }
+        latch.wait();
+        samples.insert(samples.end(), starts.begin(), starts.end());
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    reportLatency(state, samples);
+    state.counters["wakeups/task"] = (double)pool->getStats().wakeup_num_ / (double)std::max(total, 1L);
+}
+
+
+// 逐个提交并等待，反映空闲线程被唤醒的延迟
+static void BM_PingPongLatency(benchmark::State& state) {
+    auto pool = makePool((int)state.range(0));
+    std::vector<long> samples;
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        long submit = nowNs();
+        long start = 0;
+        pool->commit([&start] { start = nowNs(); }).wait();
+        samples.emplace_back(start - submit);
+        total++;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    reportLatency(state, samples);
+}
+
+
+/**
+ * fork-join 形式的 fib，子任务由 worker 内部继续提交
+ * 通过 latch 汇合，避免在 worker 中阻塞等待 future
+ */
+static long serialFib(int n) {
+    return n < 2 ? n : serialFib(n - 1) + serialFib(n - 2);
+}
+
+static void forkFib(ThreadPool* pool, int n, std::atomic<long>* sum, SuiteLatch* latch, std::atomic<long>* tasks) {
+    tasks->fetch_add(1, std::memory_order_relaxed);
+    if (n < SUITE_FIB_CUTOFF) {
+        sum->fetch_add(serialFib(n), std::memory_order_relaxed);
+    } else {
+        latch->add(2);
+        pool->commit([=] { forkFib(pool, n - 1, sum, latch, tasks); });
+        pool->commit([=] { forkFib(pool, n - 2, sum, latch, tasks); });
+    }
+    latch->countDown();
+}
+
+static void BM_ForkJoinFib(benchmark::State& state) {
+    auto pool = makePool((int)state.range(0));
+    const int n = (int)state.range(1);
+    std::atomic<long> tasks {0};
+    auto stealBefore = pool->getStats().total().steal_num_;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        std::atomic<long> sum {0};
+        SuiteLatch latch(1);
+        ThreadPool* ptr = pool.get();
+        pool->commit([&, ptr] { forkFib(ptr, n, &sum, &latch, &tasks); });
+        latch.wait();
+        benchmark::DoNotOptimize(sum.load());
+    }
+    reportThroughput(state, tasks.load(), cpuSeconds() - cpuStart);
+    reportSteals(state, pool.get(), stealBefore, tasks.load());
+}
+
+
+// fork-join 形式的 quicksort
+static void forkSort(ThreadPool* pool, int* begin, int* end, SuiteLatch* latch, std::atomic<long>* tasks) {
+    tasks->fetch_add(1, std::memory_order_relaxed);
+    if (end - begin <= SUITE_SORT_CUTOFF) {
+        std::sort(begin, end);
+    } else {
+        int pivot = *(begin + (end - begin) / 2);
+        int* mid1 = std::partition(begin, end, [pivot](int v) { return v < pivot; });
+        int* mid2 = std::partition(mid1, end, [pivot](int v) { return !(pivot < v); });
+        latch->add(2);
+        pool->commit([=] { forkSort(pool, begin, mid1, latch, tasks); });
+        pool->commit([=] { forkSort(pool, mid2, end, latch, tasks); });
+    }
+    latch->countDown();
+}
+
+static void BM_ForkJoinQuicksort(benchmark::State& state) {
+    auto pool = makePool((int)state.range(0));
+    std::vector<int> origin((size_t)state.range(1));
+    std::mt19937 generator(42);
+    for (auto& v : origin) {
+        v = (int)generator();
+    }
+    std::atomic<long> tasks {0};
+    auto stealBefore = pool->getStats().total().steal_num_;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<int> data = origin;
+        state.ResumeTiming();
+
+        SuiteLatch latch(1);
+        ThreadPool* ptr = pool.get();
+        int* begin = data.data();
+        int* end = data.data() + data.size();
+        pool->commit([&, ptr, begin, end] { forkSort(ptr, begin, end, &latch, &tasks); });
+        latch.wait();
+        benchmark::DoNotOptimize(data.data());
+    }
+    reportThroughput(state, tasks.load(), cpuSeconds() - cpuStart);
+    reportSteals(state, pool.get(), stealBefore, tasks.load());
+}
+
+
+/**
+ * 负载倾斜：所有任务均投递到 0 号主线程，依赖 steal 机制分摊
+ */
+static void BM_SkewedLoad(benchmark::State& state) {
+    auto pool = makePool((int)state.range(0));
+    const long num = state.range(1);
+    long total = 0;
+    auto stealBefore = pool->getStats().total().steal_num_;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        SuiteLatch latch(num);
+        for (long i = 0; i < num; i++) {
+            pool->commit([&latch] {
+                volatile long acc = 0;
+                for (int k = 0; k < 2000; k++) {
+                    acc = acc + k;
+                }
+                latch.countDown();
+            }, 0);
+        }
+        latch.wait();
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    reportSteals(state, pool.get(), stealBefore, total);
+}
+
+
+// 多个生产者同时提交
+static void BM_ProducerScaling(benchmark::State& state) {
+    auto pool = makePool((int)state.range(0));
+    const int producers = (int)state.range(1);
+    const long perProducer = state.range(2);
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        SuiteLatch latch(producers * perProducer);
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&] {
+                for (long i = 0; i < perProducer; i++) {
+                    pool->commit([&latch] { latch.countDown(); });
+                }
+            });
+        }
+        for (auto& thd : threads) {
+            thd.join();
+        }
+        latch.wait();
+        total += producers * perProducer;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+}
+
+
+// 线程池空闲时的cpu消耗，单位为 cpu ms / 空闲 s
+static void BM_IdleCpuBurn(benchmark::State& state) {
+    auto pool = makePool((int)state.range(0));
+    const long idleMs = state.range(1);
+    double cpuCost = 0.0;
+    double idleCost = 0.0;
+    for (auto _ : state) {
+        double cpuStart = cpuSeconds();
+        std::this_thread::sleep_for(std::chrono::milliseconds(idleMs));
+        cpuCost += cpuSeconds() - cpuStart;
+        idleCost += (double)idleMs / 1000.0;
+    }
+    state.counters["cpu_ms/idle_s"] = idleCost > 0 ? cpuCost * 1000.0 / idleCost : 0.0;
+}
+
+
+// 长短任务混合（每100个任务中有一个 sleep 5ms 的长任务），统计短任务从 commit 到开始执行的延迟，对比不同的分发策略
+static void BM_MixedDurationTail(benchmark::State& state) {
+    const int threads = (int)state.range(0);
+    ThreadPoolConfig config;
+    config.default_thread_size_ = threads;
+    config.secondary_thread_size_ = 0;
+    config.max_thread_size_ = threads;
+    config.dispatch_policy_ = (int)state.range(1);
+    ThreadPool pool(true, config);
+
+    const long num = state.range(2);
+    std::vector<long> samples;
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        std::vector<long> starts(num, -1);
+        SuiteLatch latch(num);
+        for (long i = 0; i < num; i++) {
+            long submit = nowNs();
+            bool longTask = (0 == i % 100);
+            pool.commit([&starts, &latch, submit, i, longTask] {
+                if (longTask) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                } else {
+                    starts[i] = nowNs() - submit;
+                }
+                latch.countDown();
+            });
+            if (0 == i % 10) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));     // 模拟持续到达的流量
+            }
+        }
+        latch.wait();
+        for (long cost : starts) {
+            if (cost >= 0) {
+                samples.emplace_back(cost);
+            }
+        }
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    reportLatency(state, samples);
+}
+
+
+// 提交任务的同时，另一个线程不断在 [1, threads] 之间调整主线程数量，统计吞吐和单次调整的耗时
+static void BM_ElasticResize(benchmark::State& state) {
+    const int threads = (int)state.range(0);
+    auto pool = makePool(threads);
+    const long num = state.range(1);
+    long total = 0;
+    long resizeNum = 0;
+    long resizeNs = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        std::atomic<bool> running(true);
+        std::thread resizer([&] {
+            int size = threads;
+            while (running.load(std::memory_order_relaxed)) {
+                size = (size == threads) ? std::max(threads / 2, 1) : threads;
+                long start = nowNs();
+                pool->resizePrimaryThread(size);
+                resizeNs += nowNs() - start;
+                resizeNum++;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        SuiteLatch latch(num);
+        for (long i = 0; i < num; i++) {
+            pool->commit([&latch] { latch.countDown(); });
+        }
+        latch.wait();
+        running.store(false, std::memory_order_relaxed);
+        resizer.join();
+        total += num;
+    }
+    pool->resizePrimaryThread(threads);
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    state.counters["resize_us"] = resizeNum > 0 ? (double)resizeNs / (double)resizeNum / 1000.0 : 0.0;
+}
+
+
+// 按 key 有序执行：对比每个 key 一把锁（阻塞线程）和串行执行器（strand），并校验同一个 key 的执行顺序
+static void BM_KeyedOrdering(benchmark::State& state) {
+    auto pool = makePool((int)state.range(0));
+    const bool useStrand = (0 != state.range(1));
+    const int keys = (int)state.range(2);
+    const long num = state.range(3);
+
+    std::vector<SerialExecutorPtr> strands;
+    std::vector<std::unique_ptr<std::mutex>> mutexes;
+    for (int k = 0; k < keys; k++) {
+        strands.emplace_back(pool->strand(std::to_string(k)));
+        mutexes.emplace_back(new std::mutex());
+    }
+
+    std::vector<long> expected(keys, 0);
+    std::atomic<long> disorder(0);
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        std::vector<long> sequence(keys, 0);
+        SuiteLatch latch(num);
+        for (long i = 0; i < num; i++) {
+            int key = (int)(i % keys);
+            long seq = expected[key]++;
+            auto func = [&sequence, &disorder, key, seq] {
+                if (sequence[key] != seq) {
+                    disorder.fetch_add(1, std::memory_order_relaxed);
+                }
+                sequence[key] = seq + 1;
+            };
+            if (useStrand) {
+                strands[key]->commit([func, &latch] {
+                    func();
+                    latch.countDown();
+                });
+            } else {
+                auto* mtx = mutexes[key].get();
+                pool->commit([mtx, func, &latch] {
+                    {
+                        LOCK_GUARD lk(*mtx);
+                        func();
+                    }
+                    latch.countDown();          // 释放锁之后再通知，防止 mutexes 析构时仍被持有
+                });
+            }
+        }
+        latch.wait();
+        std::fill(expected.begin(), expected.end(), 0);
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    state.counters["disorder"] = (double)disorder.load();      // 同一个 key 未按提交顺序执行的次数
+}
+
+
+// 吵闹的邻居：一个租户一次性提交大量 20us 的计算任务，另一个租户持续提交少量任务
+// 统计后者从 commit 到开始执行的延迟，对比都走pool队列（先进先出）和分别使用两个同权重的任务类别
+static void BM_NoisyNeighbour(benchmark::State& state) {
+    auto pool = makePool((int)state.range(0));
+    const bool useClass = (0 != state.range(1));
+    const long flood = state.range(2);
+    const long quiet = 100;
+    auto noisyClass = pool->createTaskClass("noisy");
+    auto quietClass = pool->createTaskClass("quiet");
+
+    auto spin = [](long ns) {
+        long end = nowNs() + ns;
+        while (nowNs() < end) {}
+    };
+
+    std::vector<long> samples;
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        std::vector<long> starts(quiet, -1);
+        SuiteLatch latch(flood + quiet);
+        for (long i = 0; i < flood; i++) {
+            auto func = [&latch, &spin] {
+                spin(20000);
+                latch.countDown();
+            };
+            useClass ? (void)pool->commit(func, noisyClass) : (void)pool->commit(func, POOL_TASK_STRATEGY);
+        }
+        for (long i = 0; i < quiet; i++) {
+            long submit = nowNs();
+            auto func = [&starts, &latch, submit, i] {
+                starts[i] = nowNs() - submit;
+                latch.countDown();
+            };
+            useClass ? (void)pool->commit(func, quietClass) : (void)pool->commit(func, POOL_TASK_STRATEGY);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        latch.wait();
+        samples.insert(samples.end(), starts.begin(), starts.end());
+        total += flood + quiet;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    reportLatency(state, samples);
+    if (useClass) {
+        for (const auto& info : pool->getTaskClassStats()) {
+            state.counters[info.name_ + "_p99_wait_us"] = (double)info.wait_.percentile(0.99) / 1000.0;
+        }
+    }
+}
+
+
+// 后台持续有大量 20us 的普通任务，期间每 200us 提交一个期限为 1ms 的关键任务
+// 对比关键任务走普通 commit 和 commitBy（EDF）时，开始执行的延迟和超时比例
+static void BM_DeadlineLane(benchmark::State& state) {
+    auto pool = makePool((int)state.range(0));
+    const bool useDeadline = (0 != state.range(1));
+    const long flood = state.range(2);
+    const long critical = 100;
+
+    std::vector<long> samples;
+    long total = 0;
+    long missed = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        std::vector<long> starts(critical, -1);
+        SuiteLatch latch(flood + critical);
+        for (long i = 0; i < flood; i++) {
+            pool->commit([&latch] {
+                long end = nowNs() + 20000;
+                while (nowNs() < end) {}
+                latch.countDown();
+            });
+        }
+        for (long i = 0; i < critical; i++) {
+            long submit = nowNs();
+            auto func = [&starts, &latch, submit, i] {
+                starts[i] = nowNs() - submit;
+                latch.countDown();
+            };
+            if (useDeadline) {
+                pool->commitBy(std::chrono::steady_clock::now() + std::chrono::milliseconds(1), func);
+            } else {
+                pool->commit(func);
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        latch.wait();
+        for (long cost : starts) {
+            missed += (cost > 1000000) ? 1 : 0;
+        }
+        samples.insert(samples.end(), starts.begin(), starts.end());
+        total += flood + critical;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    reportLatency(state, samples);
+    state.counters["miss_rate"] = samples.empty() ? 0.0 : (double)missed / (double)samples.size();
+    if (useDeadline) {
+        auto info = pool->getDeadlineStats();
+        state.counters["lane_miss_rate"] = info.missRate();
+        state.counters["lane_p99_late_us"] = (double)info.lateness_.percentile(0.99) / 1000.0;
+    }
+}
+
+
+// 线程池空闲一段时间（线程已进入休眠）后提交一个期限为 1ms 的关键任务，统计开始执行的延迟和超时比例
+// 对比不同的空闲策略，覆盖 BM_DeadlineLane 没有覆盖的冷启动情况
+static void BM_DeadlineAfterIdle(benchmark::State& state) {
+    ThreadPoolConfig config;
+    config.default_thread_size_ = 2;
+    config.secondary_thread_size_ = 0;
+    config.max_thread_size_ = 2;
+    config.idle_strategy_ = (int)state.range(0);
+    ThreadPool pool(true, config);
+
+    std::vector<long> samples;
+    long missed = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::this_thread::sleep_for(std::chrono::milliseconds(state.range(1)));
+        state.ResumeTiming();
+        long submit = nowNs();
+        long start = 0;
+        pool.commitBy(std::chrono::steady_clock::now() + std::chrono::milliseconds(1),
+                      [&start] { start = nowNs(); }).wait();
+        samples.emplace_back(start - submit);
+        missed += (start - submit > 1000000) ? 1 : 0;
+    }
+    reportLatency(state, samples);
+    state.counters["miss_rate"] = samples.empty() ? 0.0 : (double)missed / (double)samples.size();
+}
+
+
+// 单个辅助线程持续处理优先级为100的 50us 任务，期间穿插提交优先级为-100的任务
+// 对比关闭/开启优先级老化时，低优先级任务的完成延迟，以及优先级队列的最长等待
+static void BM_PriorityStarvation(benchmark::State& state) {
+    ThreadPoolConfig config;
+    config.default_thread_size_ = 1;
+    config.secondary_thread_size_ = 1;
+    config.max_thread_size_ = 2;
+    config.monitor_enable_ = false;
+    config.priority_aging_rate_ = state.range(0) > 0 ? 1.0 : 0.0;          // 老化默认关闭，需显式开启
+    config.priority_aging_cap_ = (int)state.range(0);
+    ThreadPool pool(true, config);
+
+    const long rounds = 80;
+    const long low = 10;
+    std::vector<long> samples;
+    unsigned long maxWait = 0;
+    for (auto _ : state) {
+        std::vector<long> costs(low, -1);
+        SuiteLatch latch(low);
+        for (long r = 0; r < rounds; r++) {
+            // 保证优先级队列中始终有高优先级任务积压
+            for (int i = 0; i < 100; i++) {
+                pool.commitWithPriority([] {
+                    long end = nowNs() + 50000;
+                    while (nowNs() < end) {}
+                }, 100);
+            }
+            if (r < low) {
+                long submit = nowNs();
+                pool.commitWithPriority([&costs, &latch, submit, r] {
+                    costs[r] = nowNs() - submit;
+                    latch.countDown();
+                }, -100);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            maxWait = std::max(maxWait, pool.getStats().priority_queue_max_wait_);
+        }
+        latch.wait();
+        for (long cost : costs) {
+            samples.emplace_back(cost);
+        }
+
+        state.PauseTiming();
+        while (pool.getStats().priority_queue_size_ > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        state.ResumeTiming();
+    }
+    reportLatency(state, samples);
+    state.counters["max_wait_ms"] = (double)maxWait / 1000000.0;
+}
+
+
+// 默认策略下混入慢任务（每20个任务中有一个 sleep 4ms），统计其余任务从 commit 到开始执行的延迟
+// 对比关闭/开启按类型自动识别长时间任务
+static void BM_AutoRoute(benchmark::State& state) {
+    ThreadPoolConfig config;
+    config.default_thread_size_ = 2;
+    config.secondary_thread_size_ = 0;
+    config.max_thread_size_ = 4;
+    config.monitor_enable_ = false;
+    config.auto_route_enable_ = (0 != state.range(0));
+    ThreadPool pool(true, config);
+
+    const long num = state.range(1);
+    std::vector<long> samples;
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        std::vector<long> starts(num, -1);
+        SuiteLatch latch(num);
+        for (long i = 0; i < num; i++) {
+            if (0 == i % 20) {
+                pool.commit([&latch] {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(4));
+                    latch.countDown();
+                });
+            } else {
+                long submit = nowNs();
+                pool.commit([&starts, &latch, submit, i] {
+                    starts[i] = nowNs() - submit;
+                    latch.countDown();
+                });
+            }
+            if (0 == i % 10) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));     // 模拟持续到达的流量
+            }
+        }
+        latch.wait();
+        for (long cost : starts) {
+            if (cost >= 0) {
+                samples.emplace_back(cost);
+            }
+        }
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    reportLatency(state, samples);
+    long longTypes = 0;
+    for (const auto& info : pool.getTaskProfiles()) {
+        longTypes += info.is_long_ ? 1 : 0;
+    }
+    state.counters["long_types"] = (double)longTypes;
+}
+
+
+// io 与计算混合：每10个任务中有一个 sleep 5ms 的 io 任务，其余为 50us 的计算任务，均通过默认策略提交
+// 对比 io 任务直接阻塞主线程，和在 blocking() 中执行（由补偿线程接替）时的整体完成耗时
+static void BM_ManagedBlocking(benchmark::State& state) {
+    const int threads = (int)state.range(0);
+    ThreadPoolConfig config;
+    config.default_thread_size_ = threads;
+    config.secondary_thread_size_ = 0;
+    config.max_thread_size_ = threads * 4;
+    config.monitor_enable_ = false;
+    ThreadPool pool(true, config);
+
+    const bool managed = (0 != state.range(1));
+    const long num = state.range(2);
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        SuiteLatch latch(num);
+        for (long i = 0; i < num; i++) {
+            if (0 == i % 10) {
+                pool.commit([&pool, &latch, managed] {
+                    auto io = [] { std::this_thread::sleep_for(std::chrono::milliseconds(5)); };
+                    managed ? pool.blocking(io) : io();
+                    latch.countDown();
+                });
+            } else {
+                pool.commit([&latch] {
+                    long end = nowNs() + 50000;
+                    while (nowNs() < end) {}
+                    latch.countDown();
+                });
+            }
+        }
+        latch.wait();
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    state.counters["compensate/iter"] = (double)pool.getStats().compensate_spawn_num_ / (double)state.iterations();
+}
+
+
+// socketpair 上的 ping-pong：对比独立的 epoll 事件循环 + commit，与线程池内置 reactor 的往返延迟
+static void BM_ReactorPingPong(benchmark::State& state) {
+    const bool useReactor = (0 != state.range(0));
+    ThreadPoolConfig config;
+    config.default_thread_size_ = (int)state.range(1);
+    config.secondary_thread_size_ = 0;
+    config.max_thread_size_ = config.default_thread_size_;
+    config.reactor_thread_size_ = useReactor ? 1 : 0;
+    ThreadPool pool(true, config);
+
+    int fds[2] = {-1, -1};
+    if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+        state.SkipWithError("socketpair failed");
+        return;
+    }
+    int client = fds[0];
+    int server = fds[1];
+    fcntl(server, F_SETFL, fcntl(server, F_GETFL) | O_NONBLOCK);
+
+    // 服务端：读完所有数据，原样写回
+    auto echo = [](int fd) {
+        char buf[64];
+        ssize_t len = 0;
+        while ((len = read(fd, buf, sizeof(buf))) > 0) {
+            ssize_t ret = write(fd, buf, (size_t)len);
+            (void)ret;
+        }
+    };
+
+    int loopFd = -1;
+    int stopFd[2] = {-1, -1};
+    std::thread loop;
+    if (useReactor) {
+        pool.getReactor()->add(server, EPOLLIN, [echo](int fd, unsigned int) { echo(fd); });
+    } else {
+        // 独立的事件循环，每个就绪事件通过 commit 交给线程池处理，处理完成后重新监听
+        loopFd = epoll_create1(0);
+        if (0 != pipe(stopFd)) {
+            state.SkipWithError("pipe failed");
+            return;
+        }
+        epoll_event event {};
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.fd = server;
+        epoll_ctl(loopFd, EPOLL_CTL_ADD, server, &event);
+        event.events = EPOLLIN;
+        event.data.fd = stopFd[0];
+        epoll_ctl(loopFd, EPOLL_CTL_ADD, stopFd[0], &event);
+        loop = std::thread([&pool, echo, loopFd, server, stopFd] {
+            epoll_event ready[8];
+            while (true) {
+                int num = epoll_wait(loopFd, ready, 8, -1);
+                for (int i = 0; i < num; i++) {
+                    if (stopFd[0] == ready[i].data.fd) {
+                        return;
+                    }
+                    pool.commit([echo, loopFd, server] {
+                        echo(server);
+                        epoll_event rearm {};
+                        rearm.events = EPOLLIN | EPOLLONESHOT;
+                        rearm.data.fd = server;
+                        epoll_ctl(loopFd, EPOLL_CTL_MOD, server, &rearm);
+                    });
+                }
+            }
+        });
+    }
+
+    std::vector<long> samples;
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    char byte = 'x';
+    for (auto _ : state) {
+        long start = nowNs();
+        if (1 != write(client, &byte, 1) || 1 != read(client, &byte, 1)) {
+            state.SkipWithError("ping-pong failed");
+            break;
+        }
+        samples.emplace_back(nowNs() - start);
+        total++;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    reportLatency(state, samples);
+
+    if (useReactor) {
+        pool.getReactor()->remove(server);
+    } else {
+        ssize_t ret = write(stopFd[1], &byte, 1);
+        (void)ret;
+        loop.join();
+    }
+    pool.destroy();     // 等待已分发的回调执行完，再关闭 fd
+    for (int fd : {client, server, loopFd, stopFd[0], stopFd[1]}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+
+/**
+ * 生成用于读取测试的临时文件，进程内只生成一次
+ * @return 文件路径，失败时为空
+ */
+static const std::string& suiteDataFile() {
+    static const long SIZE = 32L << 20;
+    static std::string path = [] {
+        std::string name = "/tmp/ccy_bench_async_io.dat";
+        int fd = open(name.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+        if (fd < 0) {
+            return std::string();
+        }
+        std::vector<char> block(1 << 20, 'a');
+        for (long off = 0; off < SIZE; off += (long)block.size()) {
+            if ((ssize_t)block.size() != write(fd, block.data(), block.size())) {
+                close(fd);
+                return std::string();
+            }
+        }
+        close(fd);
+        return name;
+    }();
+    return path;
+}
+
+// 按固定大小分块读取整个文件：对比在 commit 的任务中阻塞 pread，与 readAsync 的吞吐
+static void BM_AsyncFileRead(benchmark::State& state) {
+    const bool async = (0 != state.range(0));
+    const long chunk = state.range(1);
+    const std::string& path = suiteDataFile();
+    int fd = path.empty() ? -1 : open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        state.SkipWithError("data file open failed");
+        return;
+    }
+    const long size = (long)lseek(fd, 0, SEEK_END);
+    std::vector<char> buf((size_t)size);
+
+    auto pool = makePool(2);
+    long total = 0;
+    std::atomic<long> bytes {0};
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        const long num = size / chunk;
+        SuiteLatch latch(num);
+        for (long i = 0; i < num; i++) {
+            char* dst = buf.data() + i * chunk;
+            if (async) {
+                pool->readAsync(fd, i * chunk, dst, (size_t)chunk, [&bytes, &latch](long ret) {
+                    bytes.fetch_add(ret > 0 ? ret : 0, std::memory_order_relaxed);
+                    latch.countDown();
+                });
+            } else {
+                pool->commit([fd, i, chunk, dst, &bytes, &latch] {
+                    ssize_t ret = pread(fd, dst, (size_t)chunk, i * chunk);
+                    bytes.fetch_add(ret > 0 ? ret : 0, std::memory_order_relaxed);
+                    latch.countDown();
+                });
+            }
+        }
+        latch.wait();
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    state.SetBytesProcessed(bytes.load());
+    state.counters["uring"] = async ? (double)pool->getAsyncIoStats().is_uring_ : 0.0;
+    pool.reset();
+    close(fd);
+}
+
+
+// 每个任务等待一个 1ms 后就绪的 future：对比在普通任务中阻塞 get()，与协程中 await() 让出工作线程
+static void BM_FiberAwait(benchmark::State& state) {
+    const bool fiber = (0 != state.range(0));
+    const long num = state.range(2);
+    auto pool = makePool((int)state.range(1));
+
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        SuiteLatch latch(num);
+        for (long i = 0; i < num; i++) {
+            auto body = [&latch] {
+                auto io = std::async(std::launch::async, [] {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                });
+                Fiber::await(io);
+                latch.countDown();
+            };
+            fiber ? (void)pool->commitFiber(body) : (void)pool->commit(body);
+        }
+        latch.wait();
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+}
+
+
+// 子进程写入定长的任务描述，本进程的线程池执行：对比 unix socket 转交，与共享内存队列 + futex 唤醒
+static void BM_SharedQueueHandoff(benchmark::State& state) {
+    const bool shared = (0 != state.range(0));
+    const long num = state.range(1);
+    auto pool = makePool(2);
+
+    std::atomic<SuiteLatch*> latch {nullptr};
+    auto handler = [&latch](const SharedTaskDesc& desc) {
+        benchmark::DoNotOptimize(desc.payload_[0]);
+        latch.load()->countDown();
+    };
+
+    SharedMemoryQueue queue;
+    int fds[2] = {-1, -1};
+    std::thread reader;
+    if (shared) {
+        if (!queue.create("", 4096).isOK() || !pool->bindSharedQueue(&queue, handler).isOK()) {
+            state.SkipWithError("shared queue create failed");
+            return;
+        }
+    } else {
+        if (0 != socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds)) {
+            state.SkipWithError("socketpair failed");
+            return;
+        }
+        // 传统方式：读取线程从 socket 中取出任务描述，再 commit 到线程池
+        reader = std::thread([&pool, &handler, fd = fds[0]] {
+            SharedTaskDesc desc;
+            while (sizeof(desc) == read(fd, &desc, sizeof(desc))) {
+                pool->commit([&handler, desc] { handler(desc); });
+            }
+        });
+    }
+
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        SuiteLatch cur(num);
+        latch.store(&cur);
+        pid_t pid = fork();
+        if (0 == pid) {
+            // 子进程中仅调用 async-signal-safe 的操作
+            SharedTaskDesc desc;
+            desc.size_ = sizeof(long);
+            for (long i = 0; i < num; i++) {
+                memcpy(desc.payload_, &i, sizeof(long));
+                if (shared) {
+                    queue.push(1, desc.payload_, desc.size_);
+                } else if (sizeof(desc) != write(fds[1], &desc, sizeof(desc))) {
+                    _exit(1);
+                }
+            }
+            _exit(0);
+        }
+        cur.wait();
+        waitpid(pid, nullptr, 0);
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+
+    if (shared) {
+        pool->unbindSharedQueue(&queue);
+    } else {
+        shutdown(fds[1], SHUT_RDWR);
+        reader.join();
+        close(fds[0]);
+        close(fds[1]);
+    }
+    pool.reset();
+}
+
+
+// 线程空闲后突发提交一批短任务，对比逐个 commit() 和 commitBatch() 的完成耗时与唤醒次数
+static void BM_BatchCommit(benchmark::State& state) {
+    const bool batch = state.range(0) > 0;
+    auto pool = makePool((int)state.range(1));
+    const long num = state.range(2);
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));      // 等待线程进入休眠
+        state.ResumeTiming();
+
+        SuiteLatch latch(num);
+        if (batch) {
+            std::vector<std::function<void()>> funcs(num, [&latch] { latch.countDown(); });
+            pool->commitBatch(funcs);
+        } else {
+            for (long i = 0; i < num; i++) {
+                pool->commit([&latch] { latch.countDown(); });
+            }
+        }
+        latch.wait();
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    state.counters["wakeups/task"] = (double)pool->getStats().wakeup_num_ / (double)std::max(total, 1L);
+}
+
+
+// 任务以固定间隔逐个到达，对比不同空闲策略下的唤醒延迟与cpu消耗（含空闲期间的空转）
+static void BM_IdleStrategy(benchmark::State& state) {
+    ThreadPoolConfig config;
+    config.default_thread_size_ = 2;
+    config.secondary_thread_size_ = 0;
+    config.max_thread_size_ = 2;
+    config.idle_strategy_ = (int)state.range(0);
+    ThreadPool pool(true, config);
+    const long gapUs = state.range(1);
+    std::vector<long> samples;
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        if (gapUs > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(gapUs));
+        }
+        long submit = nowNs();
+        long start = 0;
+        pool.commit([&start] { start = nowNs(); }).wait();
+        samples.emplace_back(start - submit);
+        total++;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    reportLatency(state, samples);
+}
+
+
+// 主线程持续执行批量任务（每个任务约20us）时，控制类任务从提交到开始执行的延迟，对比普通提交和实时线程
+static void BM_RealtimeLane(benchmark::State& state) {
+    const bool realtime = state.range(0) > 0;
+    ThreadPoolConfig config;
+    config.default_thread_size_ = 2;
+    config.secondary_thread_size_ = 0;
+    config.max_thread_size_ = 2;
+    config.realtime_thread_size_ = realtime ? 1 : 0;
+    // 默认不绑定cpu。在已隔离cpu的机器上，可将其写入 realtime_thread_cpus_，对比绑定和实时调度的效果
+    ThreadPool pool(true, config);
+
+    std::atomic<bool> stop {false};
+    std::atomic<long> inflight {0};
+    std::thread producer([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (inflight.load(std::memory_order_relaxed) >= 64) {
+                std::this_thread::yield();
+                continue;
+            }
+            inflight.fetch_add(1, std::memory_order_relaxed);
+            pool.commit([&inflight] {
+                long end = nowNs() + 20000;
+                while (nowNs() < end) {}
+                inflight.fetch_sub(1, std::memory_order_relaxed);
+            });
+        }
+    });
+
+    std::vector<long> samples;
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        long submit = nowNs();
+        long start = 0;
+        auto func = [&start] { start = nowNs(); };
+        (realtime ? pool.commitRealtime(func) : pool.commit(func)).wait();
+        samples.emplace_back(start - submit);
+        total++;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    reportLatency(state, samples);
+
+    stop.store(true, std::memory_order_relaxed);
+    producer.join();
+    auto stats = pool.getStats();
+    state.counters["pinned"] = stats.realtime_pinned_num_;
+    state.counters["sched_fifo"] = stats.realtime_sched_num_;
+}
+
+
+// 分配密集型任务（每个任务构造若干临时的 vector / string），对比默认堆内存和工作线程的临时内存
+static void BM_ScratchArena(benchmark::State& state) {
+    const bool arena = state.range(0) > 0;
+    auto pool = makePool((int)state.range(1));
+    const long num = state.range(2);
+
+    std::atomic<long> checksum {0};
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        std::vector<std::future<void>> futures;
+        futures.reserve(num);
+        for (long i = 0; i < num; i++) {
+            futures.emplace_back(pool->commit([arena, i, &checksum] {
+                std::pmr::memory_resource* res = arena ? ThreadPool::currentArena() : std::pmr::new_delete_resource();
+                std::pmr::vector<std::pmr::string> words(res);
+                std::pmr::vector<long> values(res);
+                for (int k = 0; k < 64; k++) {
+                    values.push_back(i * k);
+                    words.emplace_back(48, (char)('a' + k % 26));
+                }
+                checksum.fetch_add(values.back() + (long)words.size(), std::memory_order_relaxed);
+            }));
+        }
+        for (auto& fut : futures) {
+            fut.wait();
+        }
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+    benchmark::DoNotOptimize(checksum.load());
+}
+
+
+// 并行聚合：每个任务将一段数据写入16个桶的直方图，对比共享的原子计数器和每线程累加对象
+static void BM_Combinable(benchmark::State& state) {
+    const bool combinable = state.range(0) > 0;
+    auto pool = makePool((int)state.range(1));
+    const long num = state.range(2);
+    const int perTask = 4096;
+    using Histogram = std::array<long, 16>;
+
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        std::atomic<long> shared[16] {};
+        Combinable<Histogram> local([] { return Histogram {}; });
+        std::vector<std::future<void>> futures;
+        futures.reserve(num);
+        for (long i = 0; i < num; i++) {
+            futures.emplace_back(pool->commit([&, i] {
+                unsigned long x = (unsigned long)i * 2654435761UL + 1;
+                Histogram* hist = combinable ? &local.local() : nullptr;
+                for (int k = 0; k < perTask; k++) {
+                    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                    if (combinable) {
+                        (*hist)[x & 15]++;
+                    } else {
+                        shared[x & 15].fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            }));
+        }
+        for (auto& fut : futures) {
+            fut.wait();
+        }
+
+        long sum = 0;
+        if (combinable) {
+            local.forEach([&sum](const Histogram& hist) {
+                for (long v : hist) { sum += v; }
+            });
+        } else {
+            for (auto& v : shared) { sum += v.load(); }
+        }
+        if (sum != num * perTask) {
+            state.SkipWithError("histogram lost updates");
+            break;
+        }
+        total += num;
+    }
+    reportThroughput(state, total, cpuSeconds() - cpuStart);
+}
+
+
+// BSP 式的迭代计算：多轮细粒度任务（每轮 parties 个任务），每轮全部结束后才开始下一轮
+// 对比调用方逐轮阻塞提交 TaskGroup（每个任务一个 future），和由 Phaser 的 onAdvance 直接提交下一轮
+static void BM_PhaserRounds(benchmark::State& state) {
+    const bool phaser = state.range(0) > 0;
+    auto pool = makePool((int)state.range(1));
+    const int parties = (int)state.range(2);
+    const unsigned long rounds = (unsigned long)state.range(3);
+
+    std::vector<long> cells(parties * 16, 0);        // 每个参与方独占一个 cache line
+    auto work = [&cells](int party) {
+        long sum = cells[party * 16];
+        for (int k = 0; k < 64; k++) {
+            sum = sum * 31 + k;
+        }
+        cells[party * 16] = sum;
+    };
+
+    long total = 0;
+    double cpuStart = cpuSeconds();
+    for (auto _ : state) {
+        if (phaser) {
+            ThreadPool* p = pool.get();
+            Phaser* self = nullptr;
+            Phaser ph(parties, [&](unsigned long phase) {
+                if (phase + 1 >= rounds) {
+                    return true;
+                }
+                p->commitPhase(self, work);
+                return false;
+            });
+            self = &ph;
+            pool->commitPhase(&ph, work);
+            ph.awaitAdvance(rounds - 1);
+        } else {
+            for (unsigned long r = 0; r < rounds; r++) {
+                TaskGroup group;
+                for (int party = 0; party < parties; party++) {
+                    group.addTask([&work, party] { work(party); });
+                }
+                pool->submit(group);
+            }
+        }
+        total += (long)rounds;
+    }
+    reportThroughput(state, total * parties, cpuSeconds() - cpuStart);
+    state.counters["rounds/s"] = benchmark::Counter((double)total, benchmark::Counter::kIsRate);
+    benchmark::DoNotOptimize(cells.data());
+}
+
+
+// 突发的阻塞型任务（每个任务 sleep 1ms），对比开启/关闭自动扩容时，一次突发的完成耗时
+static void BM_BurstAutoscale(benchmark::State& state) {
+    ThreadPoolConfig config;
+    config.default_thread_size_ = 2;
+    config.secondary_thread_size_ = 0;
+    config.max_thread_size_ = 16;
+    config.monitor_enable_ = (0 != state.range(0));
+    config.secondary_thread_ttl_ = 0;        // 突发结束后立即回收，保证每一轮都从零开始扩容
+    ThreadPool pool(true, config);
+
+    const long num = state.range(1);
+    unsigned long peak = 0;
+    for (auto _ : state) {
+        SuiteLatch latch(num);
+        for (long i = 0; i < num; i++) {
+            pool.commit([&latch] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                latch.countDown();
+            }, POOL_TASK_STRATEGY);
+        }
+        latch.wait();
+        peak = std::max(peak, (unsigned long)pool.getStats().secondary_threads_.size());
+
+        state.PauseTiming();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        state.ResumeTiming();
+    }
+
+    auto monitor = pool.getStats().monitor_;
+    state.counters["peak_secondary"] = (double)peak;
+    state.counters["scale_up/burst"] = (double)monitor.scale_up_num_ / (double)state.iterations();
+    state.counters["scale_down/burst"] = (double)monitor.scale_down_thread_num_ / (double)state.iterations();
+}
+
+
+// 线程数矩阵
+static void threadMatrix(benchmark::internal::Benchmark* bm, const std::vector<int64_t>& others) {
+    for (int64_t threads : {1, 2, 4, 8, 16}) {
+        std::vector<int64_t> args = {threads};
+        args.insert(args.end(), others.begin(), others.end());
+        bm->Args(args);
+    }
+}
+
+BENCHMARK(BM_Throughput)->Apply([](benchmark::internal::Benchmark* bm) {
+    threadMatrix(bm, {100000});
+})->ArgNames({"threads", "tasks"})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ThroughputWithHistogram)->Apply([](benchmark::internal::Benchmark* bm) {
+    threadMatrix(bm, {100000});
+})->ArgNames({"threads", "tasks"})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ThroughputWithTrace)->Apply([](benchmark::internal::Benchmark* bm) {
+    threadMatrix(bm, {100000});
+})->ArgNames({"threads", "tasks"})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_BurstLatency)->Apply([](benchmark::internal::Benchmark* bm) {
+    threadMatrix(bm, {10000});
+})->ArgNames({"threads", "tasks"})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_PingPongLatency)->Apply([](benchmark::internal::Benchmark* bm) {
+    threadMatrix(bm, {});
+})->ArgNames({"threads"})->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_ForkJoinFib)->Apply([](benchmark::internal::Benchmark* bm) {
+    threadMatrix(bm, {30});
+})->ArgNames({"threads", "n"})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ForkJoinQuicksort)->Apply([](benchmark::internal::Benchmark* bm) {
+    threadMatrix(bm, {1 << 20});
+})->ArgNames({"threads", "size"})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_SkewedLoad)->Apply([](benchmark::internal::Benchmark* bm) {
+    threadMatrix(bm, {20000});
+})->ArgNames({"threads", "tasks"})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ProducerScaling)->Apply([](benchmark::internal::Benchmark* bm) {
+    for (int64_t producers : {1, 2, 4, 8}) {
+        threadMatrix(bm, {producers, 20000});
+    }
+})->ArgNames({"threads", "producers", "tasks"})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_IdleCpuBurn)->Apply([](benchmark::internal::Benchmark* bm) {
+    threadMatrix(bm, {200});
+})->ArgNames({"threads", "idle_ms"})->UseRealTime()->Iterations(5)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_MixedDurationTail)->Apply([](benchmark::internal::Benchmark* bm) {
+    for (int64_t policy : {DISPATCH_POLICY_ROUND_ROBIN, DISPATCH_POLICY_IDLE_FIRST}) {
+        for (int64_t threads : {2, 4, 8}) {
+            bm->Args({threads, policy, 1000});
+        }
+    }
+})->ArgNames({"threads", "policy", "tasks"})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_KeyedOrdering)->Apply([](benchmark::internal::Benchmark* bm) {
+    for (int64_t strand : {0, 1}) {
+        for (int64_t threads : {2, 4, 8}) {
+            bm->Args({threads, strand, 16, 100000});
+        }
+    }
+})->ArgNames({"threads", "strand", "keys", "tasks"})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_NoisyNeighbour)->Apply([](benchmark::internal::Benchmark* bm) {
+    for (int64_t fair : {0, 1}) {
+        for (int64_t threads : {2, 4}) {
+            bm->Args({threads, fair, 5000});
+        }
+    }
+})->ArgNames({"threads", "fair", "flood"})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_DeadlineLane)->Apply([](benchmark::internal::Benchmark* bm) {
+    for (int64_t deadline : {0, 1}) {
+        for (int64_t threads : {2, 4}) {
+            bm->Args({threads, deadline, 5000});
+        }
+    }
+})->ArgNames({"threads", "deadline", "flood"})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_DeadlineAfterIdle)->ArgsProduct({{IDLE_STRATEGY_ADAPTIVE, IDLE_STRATEGY_DEEP_SLEEP}, {20}})
+    ->ArgNames({"idle_strategy", "idle_ms"})->Iterations(100)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PriorityStarvation)->Arg(0)->Arg(PRIORITY_AGING_CAP)->ArgNames({"aging_cap"})
+        ->UseRealTime()->Iterations(3)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_AutoRoute)->ArgsProduct({{0, 1}, {1000}})->ArgNames({"auto_route", "tasks"})
+        ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ManagedBlocking)->ArgsProduct({{2, 4}, {0, 1}, {400}})->ArgNames({"threads", "managed", "tasks"})
+        ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ReactorPingPong)->ArgsProduct({{0, 1}, {2, 4}})->ArgNames({"reactor", "threads"})
+        ->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_AsyncFileRead)->ArgsProduct({{0, 1}, {4 << 10, 64 << 10, 1 << 20}})->ArgNames({"async", "chunk"})
+        ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_FiberAwait)->ArgsProduct({{0, 1}, {2, 4}, {64}})->ArgNames({"fiber", "threads", "tasks"})
+        ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_SharedQueueHandoff)->ArgsProduct({{0, 1}, {20000}})->ArgNames({"shared", "tasks"})
+        ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_BatchCommit)->ArgsProduct({{0, 1}, {2, 4}, {256}})->ArgNames({"batch", "threads", "tasks"})
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_IdleStrategy)->ArgsProduct({{IDLE_STRATEGY_ADAPTIVE, IDLE_STRATEGY_BUSY_POLL, IDLE_STRATEGY_DEEP_SLEEP},
+                                         {0, 50, 2000}})->ArgNames({"strategy", "gap_us"})
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_RealtimeLane)->Arg(0)->Arg(1)->ArgNames({"realtime"})
+    ->Iterations(2000)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_ScratchArena)->ArgsProduct({{0, 1}, {1, 4}, {2000}})->ArgNames({"arena", "threads", "tasks"})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Combinable)->ArgsProduct({{0, 1}, {1, 4}, {512}})->ArgNames({"combinable", "threads", "tasks"})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_PhaserRounds)->ArgsProduct({{0, 1}, {2, 4}, {8}, {10000}})->ArgNames({"phaser", "threads", "parties", "rounds"})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ElasticResize)->Apply([](benchmark::internal::Benchmark* bm) {
+    threadMatrix(bm, {100000});
+})->ArgNames({"threads", "tasks"})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_BurstAutoscale)->ArgsProduct({{0, 1}, {300}})->ArgNames({"autoscale", "tasks"})
+        ->UseRealTime()->Iterations(5)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
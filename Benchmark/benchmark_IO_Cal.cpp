@@ -6,13 +6,17 @@
 #include <iostream>
 #include <vector>
 #include <memory>
+#include <utility>
 using namespace ccy;
 
-static void simulate_workload(benchmark::State& state, int num_threads, int num_tasks, double io_task_ratio) {
-    std::unique_ptr<ThreadPool> pool(new ThreadPool(num_threads)); 
-
+static void simulate_workload(benchmark::State& state, int num_threads, int num_tasks, double io_task_ratio,
+                              int steal_policy) {
     ThreadPoolConfig config;
+    config.default_thread_size_ = num_threads;
     config.secondary_thread_size_ = 16;
+    config.max_thread_size_ = num_threads + config.secondary_thread_size_;
+    config.secondary_steal_policy_ = steal_policy;
+    std::unique_ptr<ThreadPool> pool(new ThreadPool(true, config));
     int prio = -10;
     std::default_random_engine generator;
     std::bernoulli_distribution distribution(io_task_ratio);
@@ -51,6 +55,17 @@ static void simulate_workload(benchmark::State& state, int num_threads, int num_
             f.get();
         }
     }
+
+    auto stats = pool->getStats();
+    unsigned long secondaryTasks = 0;
+    unsigned long secondarySteals = 0;
+    for (const auto& info : stats.secondary_threads_) {
+        secondaryTasks += info.task_num_;
+        secondarySteals += info.steal_num_;
+    }
+    state.counters["secondary_task_ratio"] = stats.total().task_num_ > 0
+            ? (double)secondaryTasks / (double)stats.total().task_num_ : 0.0;
+    state.counters["secondary_steals"] = (double)secondarySteals;
 }
 
 int main(int argc, char** argv) {
@@ -70,9 +85,18 @@ int main(int argc, char** argv) {
 
     argc = remaining_argc;
 
-    benchmark::RegisterBenchmark("BM_MixedWorkload", [num_threads, num_tasks, io_task_ratio](benchmark::State& state) {
-        simulate_workload(state, num_threads, num_tasks, io_task_ratio);
-    });
+    const std::pair<const char*, int> policies[] = {
+            {"BM_MixedWorkload/steal:none", SECONDARY_STEAL_POLICY_NONE},
+            {"BM_MixedWorkload/steal:round_robin", SECONDARY_STEAL_POLICY_ROUND_ROBIN},
+            {"BM_MixedWorkload/steal:random", SECONDARY_STEAL_POLICY_RANDOM},
+            {"BM_MixedWorkload/steal:longest_queue", SECONDARY_STEAL_POLICY_LONGEST_QUEUE},
+    };
+    for (const auto& policy : policies) {
+        int steal_policy = policy.second;
+        benchmark::RegisterBenchmark(policy.first, [num_threads, num_tasks, io_task_ratio, steal_policy](benchmark::State& state) {
+            simulate_workload(state, num_threads, num_tasks, io_task_ratio, steal_policy);
+        })->UseRealTime()->Unit(benchmark::kMillisecond);
+    }
 
     benchmark::Initialize(&argc, argv);
     if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1; // This should not fail now
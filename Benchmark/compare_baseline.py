@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""
+对比 google benchmark 的 json 结果与保存的基线
+
+用法：
+    python3 compare_baseline.py current.json                  # 与默认基线对比
+    python3 compare_baseline.py current.json --baseline b.json
+    python3 compare_baseline.py current.json --update         # 将本次结果保存为基线
+    python3 compare_baseline.py current.json --threshold 10   # 劣化超过 10% 时返回非 0
+
+越大越好的指标（如 tasks/s）与越小越好的指标（如 p99_us）分别判断劣化方向。
+"""
+
+import argparse
+import json
+import os
+import shutil
+import sys
+
+DEFAULT_BASELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "baseline", "suite.json")
+
+# 指标名 -> 是否越大越好
+METRICS = {
+    "real_time": False,
+    "cpu_time": False,
+    "tasks/s": True,
+    "items_per_second": True,
+    "p50_us": False,
+    "p99_us": False,
+    "p999_us": False,
+    "cpu_ns/task": False,
+    "steals/task": None,          # 仅展示，不参与判断
+    "cpu_ms/idle_s": False,
+}
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    result = {}
+    for bench in data.get("benchmarks", []):
+        if bench.get("run_type") == "aggregate" and bench.get("aggregate_name") != "mean":
+            continue
+        result[bench["name"]] = bench
+    return result
+
+
+def change(base, cur):
+    if base == 0:
+        return 0.0
+    return (cur - base) * 100.0 / abs(base)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="compare benchmark json with baseline")
+    parser.add_argument("current")
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE)
+    parser.add_argument("--threshold", type=float, default=5.0, help="regression threshold in percent")
+    parser.add_argument("--update", action="store_true", help="store current result as baseline")
+    args = parser.parse_args()
+
+    if args.update:
+        os.makedirs(os.path.dirname(os.path.abspath(args.baseline)), exist_ok=True)
+        shutil.copyfile(args.current, args.baseline)
+        print("baseline updated: %s" % args.baseline)
+        return 0
+
+    if not os.path.exists(args.baseline):
+        print("baseline [%s] not found, run with --update first" % args.baseline)
+        return 1
+
+    base = load(args.baseline)
+    cur = load(args.current)
+    regressions = 0
+    print("%-60s %-14s %14s %14s %9s" % ("benchmark", "metric", "baseline", "current", "change"))
+    for name in sorted(cur):
+        if name not in base:
+            print("%-60s (new)" % name)
+            continue
+        for metric, higher_better in METRICS.items():
+            if metric not in cur[name] or metric not in base[name]:
+                continue
+            b, c = float(base[name][metric]), float(cur[name][metric])
+            diff = change(b, c)
+            flag = ""
+            if higher_better is not None:
+                worse = -diff if higher_better else diff
+                if worse > args.threshold:
+                    flag = "  <-- regression"
+                    regressions += 1
+                elif -worse > args.threshold:
+                    flag = "  improved"
+            print("%-60s %-14s %14.3f %14.3f %+8.2f%%%s" % (name, metric, b, c, diff, flag))
+
+    for name in sorted(set(base) - set(cur)):
+        print("%-60s (missing)" % name)
+
+    print("\n%d regression(s) beyond %.1f%%" % (regressions, args.threshold))
+    return 1 if regressions > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,103 @@
+#ifndef SERIALEXECUTOR_H
+#define SERIALEXECUTOR_H
+
+#include "../ThreadPool.h"
+#include "../Queue/LockFreeMpscQueue.h"
+
+#include <atomic>
+#include <memory>
+#include <future>
+
+namespace ccy
+{
+
+/**
+ * 串行执行器（strand）：提交到同一个执行器的任务，按照提交顺序依次执行，同一时刻最多只有一个在执行
+ * 不同执行器之间，在线程池中并行执行，执行期间不会阻塞任何线程
+ * 任务存放在无锁的 MPSC 队列中，同一时刻最多只有一个 drain 任务在线程池中排队或执行，每次连续执行一批任务
+ * @notice 需通过 std::shared_ptr 持有，推荐使用 ThreadPool::strand() 获取
+ */
+class SerialExecutor : public std::enable_shared_from_this<SerialExecutor> {
+public:
+    /**
+     * @param pool 执行任务的线程池，生命周期需长于本执行器中的任务
+     * @param batchSize 单次调度最多连续执行的任务数量
+     */
+    explicit SerialExecutor(ThreadPool* pool, int batchSize = DEFAULT_STRAND_BATCH_SIZE) {
+        pool_ = pool;
+        batch_size_ = std::max(batchSize, 1);
+    }
+
+    /**
+     * 提交任务信息
+     * @tparam FunctionType
+     * @param func
+     * @return
+     */
+    template<typename FunctionType>
+    auto commit(const FunctionType& func)
+    -> std::future<decltype(std::declval<FunctionType>()())> {
+        using ResultType = decltype(std::declval<FunctionType>()());
+
+        std::packaged_task<ResultType()> packagedTask(func);
+        std::future<ResultType> result(packagedTask.get_future());
+        queue_.push(Task(std::move(packagedTask)));
+
+        // 从0变为1的提交方，负责调度 drain 任务。之后的任务，由正在执行的 drain 任务负责
+        if (0 == pending_.fetch_add(1, std::memory_order_acq_rel)) {
+            schedule();
+        }
+        return result;
+    }
+
+    /**
+     * 获取尚未执行完的任务数量
+     * @return
+     */
+    unsigned long getPendingSize() const {
+        return pending_.load(std::memory_order_acquire);
+    }
+
+    NO_ALLOWED_COPY(SerialExecutor)
+
+protected:
+    /**
+     * 向线程池提交 drain 任务，持有自身的引用，保证执行期间不被释放
+     */
+    void schedule() {
+        auto self = shared_from_this();
+        pool_->commit([self] { self->drain(); });
+    }
+
+    /**
+     * 连续执行最多 batch_size_ 个任务。若仍有剩余，重新提交到线程池，避免长时间占用线程
+     * pending_ 大于0期间，仅有当前 drain 任务在消费队列，满足单消费者的要求
+     */
+    void drain() {
+        // 已计数的任务均已写入队列，仅可能因为其他生产者尚未完成链接而暂时不可见
+        unsigned long count = std::min(pending_.load(std::memory_order_acquire), (unsigned long)batch_size_);
+        Task task;
+        for (unsigned long i = 0; i < count; i++) {
+            while (!queue_.tryPop(task)) {
+                std::this_thread::yield();
+            }
+            task();
+        }
+
+        if (pending_.fetch_sub(count, std::memory_order_acq_rel) > count) {
+            schedule();
+        }
+    }
+
+private:
+    ThreadPool* pool_ = nullptr;
+    int batch_size_ = DEFAULT_STRAND_BATCH_SIZE;
+    LockFreeMpscQueue<Task> queue_;                                 // 待执行的任务
+    std::atomic<unsigned long> pending_ {0};                        // 已提交、未执行完的任务数量
+};
+
+using SerialExecutorPtr = std::shared_ptr<SerialExecutor>;
+
+}
+
+#endif
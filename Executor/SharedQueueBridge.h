@@ -0,0 +1,135 @@
+#ifndef SHAREDQUEUEBRIDGE_H
+#define SHAREDQUEUEBRIDGE_H
+
+#include "../ThreadPool.h"
+#include "../Queue/SharedMemoryQueue.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <functional>
+
+namespace ccy
+{
+
+/**
+ * 执行跨进程任务描述的函数，在线程池的工作线程中执行
+ */
+using SharedTaskHandler = std::function<void(const SharedTaskDesc& desc)>;
+
+
+/**
+ * 共享内存队列绑定关系的统计信息
+ */
+struct SharedQueueInfo {
+    unsigned long drain_num_ = 0;                                   // 已转交给线程池的任务数量
+    unsigned long error_num_ = 0;                                   // handler 抛出异常的次数
+};
+
+
+/**
+ * 将共享内存队列中的任务转交给线程池：单独的线程取出任务描述，直接写入主线程的本地队列
+ * 队列为空时通过 futex 休眠，不占用 cpu
+ * handler 抛出的异常在工作线程中捕获并计数，单个异常的任务描述不会导致消费进程退出
+ * @notice 推荐通过 ThreadPool::bindSharedQueue() 使用
+ */
+class SharedQueueBridge {
+public:
+    SharedQueueBridge(ThreadPool* pool, SharedMemoryQueue* queue, const SharedTaskHandler& handler) {
+        pool_ = pool;
+        queue_ = queue;
+        context_ = std::make_shared<Context>();
+        context_->handler_ = handler;
+    }
+
+    ~SharedQueueBridge() {
+        destroy();
+    }
+
+    Status init() {
+        Status status;
+        RETURN_ERROR_STATUS_BY_CONDITION(0 == queue_->getCapacity(), "shared queue is not open")
+        RETURN_ERROR_STATUS_BY_CONDITION(!context_->handler_, "shared task handler is empty")
+        if (!thread_.joinable()) {
+            stop_.store(false, std::memory_order_release);
+            thread_ = std::thread(&SharedQueueBridge::loop, this);
+        }
+        return status;
+    }
+
+    /**
+     * 停止转交。队列中剩余的任务描述保留在共享内存中，可由其他消费方继续处理
+     * @return
+     */
+    Status destroy() {
+        Status status;
+        if (thread_.joinable()) {
+            stop_.store(true, std::memory_order_release);
+            queue_->wakeAll();
+            thread_.join();
+        }
+        return status;
+    }
+
+    /**
+     * 获取已转交的任务数量
+     * @return
+     */
+    unsigned long getDrainNum() const {
+        return drain_num_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * 获取统计信息
+     * @param info
+     */
+    void snapshot(SharedQueueInfo& info) const {
+        info.drain_num_ = getDrainNum();
+        info.error_num_ = context_->error_num_.load(std::memory_order_relaxed);
+    }
+
+    NO_ALLOWED_COPY(SharedQueueBridge)
+
+protected:
+    /**
+     * 已转交的任务与 bridge 共享，解除绑定后仍可以安全执行和计数
+     */
+    struct Context {
+        SharedTaskHandler handler_;
+        std::atomic<unsigned long> error_num_ {0};
+    };
+
+    void loop() {
+        SharedTaskDesc desc;
+        while (!stop_.load(std::memory_order_acquire)) {
+            int num = 0;
+            while (num < SHARED_QUEUE_DRAIN_BATCH_SIZE && queue_->tryPop(desc)) {
+                pool_->pushCompletionTask(Task([context = context_, desc] {
+                    try {
+                        context->handler_(desc);
+                    } catch (...) {
+                        context->error_num_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }));
+                num++;
+            }
+            if (0 == num) {
+                queue_->wait(SHARED_QUEUE_WAIT_INTERVAL);
+            } else {
+                drain_num_.fetch_add(num, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    ThreadPool* pool_ = nullptr;
+    SharedMemoryQueue* queue_ = nullptr;
+    std::shared_ptr<Context> context_;
+    std::thread thread_;
+    std::atomic<bool> stop_ {false};
+    std::atomic<unsigned long> drain_num_ {0};
+};
+
+}
+
+#endif
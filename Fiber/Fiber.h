@@ -0,0 +1,244 @@
+#ifndef FIBER_H
+#define FIBER_H
+
+#include "../ThreadPool.h"
+
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <chrono>
+#include <future>
+#include <functional>
+#include <vector>
+
+namespace ccy
+{
+
+/**
+ * 协程栈，栈底（低地址）额外映射一个不可访问的保护页，栈溢出时直接触发段错误，而不是改写相邻内存
+ */
+class FiberStack {
+public:
+    FiberStack() = default;
+
+    explicit FiberStack(size_t size) {
+        page_ = (size_t)sysconf(_SC_PAGESIZE);
+        size_ = (size + page_ - 1) / page_ * page_;
+        void* ptr = mmap(nullptr, size_ + page_, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+        if (MAP_FAILED == ptr) {
+            return;
+        }
+        mprotect(ptr, page_, PROT_NONE);
+        base_ = (char*)ptr;
+    }
+
+    FiberStack(FiberStack&& stack) noexcept {
+        *this = std::move(stack);
+    }
+
+    FiberStack& operator=(FiberStack&& stack) noexcept {
+        std::swap(base_, stack.base_);
+        std::swap(size_, stack.size_);
+        std::swap(page_, stack.page_);
+        return *this;
+    }
+
+    ~FiberStack() {
+        if (nullptr != base_) {
+            munmap(base_, size_ + page_);
+        }
+    }
+
+    bool isValid() const {
+        return nullptr != base_;
+    }
+
+    /**
+     * 可用栈空间的起始地址，不含保护页
+     * @return
+     */
+    char* data() const {
+        return base_ + page_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    FiberStack(const FiberStack&) = delete;
+    FiberStack& operator=(const FiberStack&) = delete;
+
+private:
+    char* base_ = nullptr;
+    size_t size_ = 0;                                               // 可用栈空间大小，不含保护页
+    size_t page_ = 0;
+};
+
+
+/**
+ * 协程，运行在线程池的工作线程上（M:N）
+ * 协程中调用 yield() 时，切回工作线程继续执行其他任务，协程随后重新写入当前主线程的本地队列
+ * 调用 await() 时，协程暂存在当前主线程中，由其按退避的间隔检查 future，就绪后才重新写入本地队列
+ * 协程可能在不同的工作线程上恢复执行，因此不能在挂起前后依赖 thread_local 变量
+ * @notice 通过 ThreadPool::commitFiber() 创建
+ */
+class Fiber {
+public:
+    Fiber(ThreadPool* pool, Task&& body, size_t stackSize, int tag)
+        : pool_(pool), body_(std::move(body)), stack_size_(stackSize), tag_(tag) {}
+
+    /**
+     * 当前是否运行在协程中
+     * @return
+     */
+    static bool inFiber() {
+        return nullptr != threadState()->running_;
+    }
+
+    /**
+     * 挂起当前协程，让出工作线程，稍后重新调度
+     * @notice 不在协程中调用时，等同于 std::this_thread::yield()
+     */
+    static void yield() {
+        Fiber* self = threadState()->running_;
+        if (nullptr == self) {
+            std::this_thread::yield();
+            return;
+        }
+        self->suspend();
+    }
+
+    /**
+     * 等待 future 就绪并返回结果。等待期间协程挂起，不占用工作线程，工作线程空闲时仍可以休眠
+     * 就绪后最多延迟 FIBER_AWAIT_MAX_INTERVAL 恢复执行
+     * @tparam T
+     * @param fut
+     * @return
+     * @notice 不在协程中调用时，等同于 fut.get()
+     */
+    template<typename T>
+    static T await(std::future<T>& fut) {
+        Fiber* self = threadState()->running_;
+        if (nullptr != self) {
+            auto ready = [&fut] {
+                return std::future_status::ready == fut.wait_for(std::chrono::seconds(0));
+            };
+            // 在辅助线程中挂起，或所在的主线程被回收时，会提前恢复，故需再次检查
+            while (!ready()) {
+                self->wait_ready_ = ready;
+                self->suspend();
+                self->wait_ready_ = nullptr;
+            }
+        }
+        return fut.get();
+    }
+
+    NO_ALLOWED_COPY(Fiber)
+
+protected:
+    /**
+     * 工作线程内的协程调度信息
+     */
+    struct ThreadState {
+        ucontext_t scheduler_;                                      // 工作线程自身的上下文
+        Fiber* running_ = nullptr;                                  // 正在执行的协程
+        std::vector<FiberStack> stacks_;                            // 空闲栈，协程结束后回收到执行结束时所在的线程
+    };
+
+    /**
+     * 禁止内联：协程可能在其他线程恢复，每次都需要重新计算 thread_local 的地址
+     * @return
+     */
+    static __attribute__((noinline)) ThreadState* threadState() {
+        static thread_local ThreadState state;
+        return &state;
+    }
+
+    /**
+     * 在工作线程中执行（或继续执行）协程，直到协程结束或挂起
+     * 结束时回收栈并释放自身；挂起时重新调度
+     */
+    void resume() {
+        ThreadState* state = threadState();
+        if (unlikely(!stack_.isValid())) {
+            if (!prepare(state)) {
+                body_();        // 栈分配失败时，直接在工作线程上执行
+                delete this;
+                return;
+            }
+        }
+
+        state->running_ = this;
+        swapcontext(&state->scheduler_, &context_);
+        state->running_ = nullptr;
+
+        if (done_) {
+            if (state->stacks_.size() < FIBER_STACK_CACHE_SIZE && stack_.size() >= stack_size_) {
+                state->stacks_.emplace_back(std::move(stack_));
+            }
+            delete this;
+            return;
+        }
+        pool_->scheduleFiber(this);
+    }
+
+    /**
+     * 从当前线程的空闲栈中获取栈，并初始化上下文
+     * @param state
+     * @return
+     */
+    bool prepare(ThreadState* state) {
+        while (!state->stacks_.empty() && !stack_.isValid()) {
+            stack_ = std::move(state->stacks_.back());
+            state->stacks_.pop_back();
+            if (stack_.size() < stack_size_) {
+                stack_ = FiberStack();      // 栈大小设置发生变化，不再复用
+            }
+        }
+        if (!stack_.isValid()) {
+            stack_ = FiberStack(stack_size_);
+        }
+        if (!stack_.isValid() || 0 != getcontext(&context_)) {
+            return false;
+        }
+        context_.uc_stack.ss_sp = stack_.data();
+        context_.uc_stack.ss_size = stack_.size();
+        context_.uc_link = nullptr;
+        makecontext(&context_, &Fiber::entry, 0);
+        return true;
+    }
+
+    /**
+     * 切回工作线程。恢复时可能已经处于其他线程
+     */
+    void suspend() {
+        swapcontext(&context_, &threadState()->scheduler_);
+    }
+
+    /**
+     * 协程入口，执行结束后切回工作线程，不再返回
+     */
+    static void entry() {
+        Fiber* self = threadState()->running_;
+        self->body_();
+        self->done_ = true;
+        self->suspend();
+    }
+
+private:
+    ThreadPool* pool_ = nullptr;
+    Task body_;
+    size_t stack_size_ = 0;
+    int tag_ = DEFAULT_TASK_TAG;                                    // 每次调度时使用的任务标签
+    FiberStack stack_;
+    ucontext_t context_ {};
+    bool done_ = false;
+    std::function<bool()> wait_ready_;                              // await() 中等待的条件，为空时表示仅让出
+
+    friend class ThreadPool;
+};
+
+}
+
+#endif
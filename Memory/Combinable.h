@@ -0,0 +1,217 @@
+#ifndef COMBINABLE_H
+#define COMBINABLE_H
+
+#include "../ThreadObject.h"
+#include "../ThreadPoolDefine.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <functional>
+
+namespace ccy
+{
+
+/**
+ * 为每个线程分配一个紧凑的序号，从0开始。线程退出后序号被回收，供之后创建的线程复用
+ * 同一时刻存活的线程不会拥有相同的序号，主线程、辅助线程（动态创建和回收）、实时线程以及提交任务的外部线程均适用
+ */
+class ThreadSlot {
+public:
+    /**
+     * 获取当前线程的序号，首次调用时分配
+     * @return
+     */
+    static unsigned int get() {
+        static thread_local Holder holder;
+        return holder.id_;
+    }
+
+protected:
+    struct Registry {
+        std::mutex mutex_;
+        std::vector<unsigned int> free_;                            // 已回收的序号
+        unsigned int next_ = 0;                                     // 下一个未使用过的序号
+    };
+
+    /**
+     * 不析构：detach 的线程可能在静态变量析构之后才退出
+     * @return
+     */
+    static Registry* registry() {
+        static Registry* registry = new Registry();
+        return registry;
+    }
+
+    struct Holder {
+        Holder() {
+            auto* reg = registry();
+            LOCK_GUARD lk(reg->mutex_);
+            if (reg->free_.empty()) {
+                id_ = reg->next_++;
+            } else {
+                id_ = reg->free_.back();
+                reg->free_.pop_back();
+            }
+        }
+
+        ~Holder() {
+            auto* reg = registry();
+            LOCK_GUARD lk(reg->mutex_);
+            reg->free_.push_back(id_);
+        }
+
+        unsigned int id_ = 0;
+    };
+};
+
+
+/**
+ * 每个线程独立的累加对象，用于替代任务间共享的原子变量或加锁的计数器/直方图
+ * 各线程通过 local() 获取自己的副本，首次访问时才构造；副本按 cache line 对齐，线程之间不会发生伪共享
+ * 全部任务结束后，通过 combine() / forEach() 汇总各线程的结果
+ * @tparam T
+ * @notice local() 返回的引用只能在当前线程中使用。combine() / forEach() / clear() 不与 local() 同步，需在写入结束后调用
+ */
+template<typename T>
+class Combinable {
+public:
+    Combinable() : init_([] { return T(); }) {}
+
+    /**
+     * @param init 构造每个线程副本的初始值
+     */
+    explicit Combinable(std::function<T()> init) : init_(std::move(init)) {}
+
+    ~Combinable() {
+        clear();
+        for (auto& chunk : chunks_) {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * 获取当前线程的副本，不存在时构造
+     * @return
+     */
+    T& local() {
+        unsigned int id = ThreadSlot::get();
+        auto& ptr = slotRef(id);
+        Slot* slot = ptr.load(std::memory_order_acquire);
+        if (unlikely(nullptr == slot)) {
+            slot = new Slot { init_() };
+            ptr.store(slot, std::memory_order_release);
+        }
+        return slot->value_;
+    }
+
+    /**
+     * 依次访问已构造的副本
+     * @tparam Func 形如 void(T&)
+     * @param func
+     */
+    template<typename Func>
+    void forEach(Func&& func) {
+        visit([&func](Slot* slot) { func(slot->value_); });
+    }
+
+    template<typename Func>
+    void forEach(Func&& func) const {
+        visit([&func](const Slot* slot) { func((const T&)slot->value_); });
+    }
+
+    /**
+     * 汇总所有副本
+     * @tparam Op 形如 T(const T&, const T&)
+     * @param op
+     * @return 没有任何副本时，返回初始值
+     */
+    template<typename Op>
+    T combine(Op&& op) const {
+        bool first = true;
+        T result {};
+        visit([&](const Slot* slot) {
+            result = first ? slot->value_ : op((const T&)result, (const T&)slot->value_);
+            first = false;
+        });
+        return first ? init_() : result;
+    }
+
+    /**
+     * 获取已构造的副本数量
+     * @return
+     */
+    size_t size() const {
+        size_t num = 0;
+        visit([&num](const Slot*) { num++; });
+        return num;
+    }
+
+    /**
+     * 删除所有副本，之后再调用 local() 时重新构造
+     */
+    void clear() {
+        for (auto& chunk : chunks_) {
+            auto* slots = chunk.load(std::memory_order_acquire);
+            if (nullptr == slots) {
+                continue;
+            }
+            for (unsigned int i = 0; i < COMBINABLE_CHUNK_SIZE; i++) {
+                delete slots[i].exchange(nullptr, std::memory_order_acq_rel);
+            }
+        }
+    }
+
+    NO_ALLOWED_COPY(Combinable)
+
+protected:
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        T value_;
+    };
+
+    /**
+     * 分段存放副本的指针，仅在首次用到某一段时申请
+     * @param id
+     * @return
+     */
+    std::atomic<Slot*>& slotRef(unsigned int id) {
+        unsigned int index = id / COMBINABLE_CHUNK_SIZE;
+        if (unlikely(index >= COMBINABLE_CHUNK_NUM)) {
+            throw EXCEPTION("too many threads for combinable");
+        }
+        auto* slots = chunks_[index].load(std::memory_order_acquire);
+        if (unlikely(nullptr == slots)) {
+            auto* created = new std::atomic<Slot*>[COMBINABLE_CHUNK_SIZE]();
+            if (chunks_[index].compare_exchange_strong(slots, created, std::memory_order_acq_rel)) {
+                slots = created;
+            } else {
+                delete[] created;       // 其他线程已经申请，slots 已更新为对方的结果
+            }
+        }
+        return slots[id % COMBINABLE_CHUNK_SIZE];
+    }
+
+    template<typename Func>
+    void visit(Func&& func) const {
+        for (auto& chunk : chunks_) {
+            auto* slots = chunk.load(std::memory_order_acquire);
+            if (nullptr == slots) {
+                continue;
+            }
+            for (unsigned int i = 0; i < COMBINABLE_CHUNK_SIZE; i++) {
+                Slot* slot = slots[i].load(std::memory_order_acquire);
+                if (nullptr != slot) {
+                    func(slot);
+                }
+            }
+        }
+    }
+
+private:
+    std::function<T()> init_;                                                   // 构造副本的初始值
+    std::atomic<std::atomic<Slot*>*> chunks_[COMBINABLE_CHUNK_NUM] {};          // 分段存放的副本指针，按线程序号索引
+};
+
+}
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef SCRATCHARENA_H
+#define SCRATCHARENA_H
+
+#include "../ThreadObject.h"
+#include "../ThreadPoolDefine.h"
+
+#include <memory_resource>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace ccy
+{
+
+/**
+ * 工作线程独占的临时内存（bump pointer），分配时只移动指针，释放时什么都不做，由线程在任务结束后统一重置
+ * 同时实现了 std::pmr::memory_resource，可直接用于 std::pmr::vector / std::pmr::string 等容器
+ * @notice 不是线程安全的，只能在所属的工作线程中使用。分配的内存在当前任务结束后失效，不能被任务之外的对象持有
+ */
+class ScratchArena : public std::pmr::memory_resource {
+public:
+    explicit ScratchArena(size_t blockSize = SCRATCH_ARENA_BLOCK_SIZE,
+                          size_t retainSize = SCRATCH_ARENA_RETAIN_SIZE)
+        : block_size_(blockSize), retain_size_(retainSize) {}
+
+    ~ScratchArena() override {
+        for (auto& block : blocks_) {
+            std::free(block.data_);
+        }
+    }
+
+    /**
+     * 分配内存
+     * @param bytes
+     * @param align 需为2的幂
+     * @return
+     */
+    void* alloc(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        auto ptr = alignUp(cur_, align);
+        if (likely(ptr + bytes <= end_ && 0 != end_)) {
+            cur_ = ptr + bytes;
+            return (void*)ptr;
+        }
+        return allocSlow(bytes, align);
+    }
+
+    /**
+     * 重置，之前分配的内存全部失效。保留不超过 retain_size_ 的内存块，供后续任务复用
+     * 第一个内存块同样可能被释放（如首次分配就超过 block_size_ 时），之后再分配时重新申请
+     */
+    void reset() {
+        if (blocks_.empty()) {
+            return;
+        }
+        while (!blocks_.empty() && reserved_size_ > retain_size_) {
+            reserved_size_ -= blocks_.back().size_;
+            std::free(blocks_.back().data_);
+            blocks_.pop_back();
+        }
+        if (blocks_.empty()) {
+            cur_block_ = 0;
+            cur_ = 0;
+            end_ = 0;                   // 下一次分配进入 allocSlow()
+            return;
+        }
+        useBlock(0);
+    }
+
+    /**
+     * 获取当前持有的内存总量
+     * @return
+     */
+    size_t getReservedSize() const {
+        return reserved_size_;
+    }
+
+    NO_ALLOWED_COPY(ScratchArena)
+
+protected:
+    void* do_allocate(size_t bytes, size_t align) override {
+        return alloc(bytes, align);
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {
+        // 统一在 reset() 中回收
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    /**
+     * 当前内存块不足时，依次尝试后续已有的内存块，都不足时申请新的内存块
+     * @param bytes
+     * @param align
+     * @return
+     */
+    void* allocSlow(size_t bytes, size_t align) {
+        for (size_t i = cur_block_ + 1; i < blocks_.size(); i++) {
+            if (blocks_[i].size_ >= bytes + align) {
+                useBlock(i);
+                return alloc(bytes, align);
+            }
+        }
+
+        size_t size = std::max(block_size_, bytes + align);
+        auto* data = (char*)std::malloc(size);
+        if (unlikely(nullptr == data)) {
+            throw std::bad_alloc();
+        }
+        blocks_.push_back({ data, size });
+        reserved_size_ += size;
+        useBlock(blocks_.size() - 1);
+        return alloc(bytes, align);
+    }
+
+    void useBlock(size_t index) {
+        cur_block_ = index;
+        cur_ = (uintptr_t)blocks_[index].data_;
+        end_ = cur_ + blocks_[index].size_;
+    }
+
+    static uintptr_t alignUp(uintptr_t ptr, size_t align) {
+        return (ptr + align - 1) & ~(uintptr_t)(align - 1);
+    }
+
+private:
+    struct Block {
+        char* data_;
+        size_t size_;
+    };
+
+    uintptr_t cur_ = 0;                                             // 下一次分配的起始位置
+    uintptr_t end_ = 0;                                             // 当前内存块的结束位置
+    size_t cur_block_ = 0;                                          // 当前使用的内存块
+    std::vector<Block> blocks_;                                     // 持有的内存块，首次分配时申请
+    size_t block_size_ = 0;                                         // 默认的内存块大小
+    size_t retain_size_ = 0;                                        // 重置时保留的内存上限
+    size_t reserved_size_ = 0;                                      // 当前持有的内存总量
+};
+
+}
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef PHASER_H
+#define PHASER_H
+
+#include "../ThreadPool.h"
+#include "../Fiber/Fiber.h"
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <functional>
+
+namespace ccy
+{
+
+/**
+ * 阶段屏障，用于按轮次（BSP）执行的迭代计算：同一轮中，所有参与方都到达后，才进入下一轮
+ * 参与方按序号分组到达树形计数器的叶子节点，每组的最后一个到达方再向上一层到达，避免所有参与方争抢同一个计数器
+ * 推荐配合 ThreadPool::commitPhase() 使用：每个任务结束时到达，最后一个到达方执行 onAdvance，并在其中提交下一轮任务，整个过程中没有线程阻塞等待
+ * 也可以由常驻的参与方循环调用 arriveAndAwait()，此时参与方数量不应超过可用的线程数量
+ * @notice 参与方数量在构造时确定。每个参与方在一轮中只能到达一次
+ */
+class Phaser {
+public:
+    /**
+     * 每一轮结束时执行，参数为刚结束的轮次（从0开始）
+     * 返回 true 时，phaser 终止，之后不再执行 onAdvance，等待方全部返回
+     */
+    using AdvanceCallback = std::function<bool(unsigned long phase)>;
+
+    /**
+     * @param parties 参与方数量，需大于0
+     * @param onAdvance 在最后一个到达方的线程中执行，此时下一轮的到达已经可以开始
+     * @param pool 参与方在该线程池的任务中等待时，通过 BlockingScope 启动补偿线程，接替执行其他任务
+     */
+    explicit Phaser(int parties, AdvanceCallback onAdvance = nullptr, ThreadPool* pool = nullptr)
+        : parties_(parties), on_advance_(std::move(onAdvance)), pool_(pool) {
+        if (parties <= 0) {
+            throw EXCEPTION("phaser parties must be positive");
+        }
+        buildTree();
+    }
+
+    /**
+     * 等待方可能在最后一个到达方通知完成之前返回并析构 phaser，需等待其结束
+     */
+    ~Phaser() {
+        while (advancing_.load(std::memory_order_acquire) > 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * 到达当前轮次，不等待其他参与方
+     * @param party 参与方序号，范围为 [0, parties)
+     * @return 到达的轮次，可用于 awaitAdvance()
+     */
+    unsigned long arrive(int party) {
+        if (unlikely(party < 0 || party >= parties_)) {
+            throw EXCEPTION("phaser party out of range");
+        }
+        unsigned long phase = (state_.load(std::memory_order_acquire) + 1) >> 1;
+        int index = party / PHASER_TREE_FANOUT;
+        while (true) {
+            Node& node = nodes_[index];
+            if (1 != node.count_.fetch_sub(1, std::memory_order_acq_rel)) {
+                return phase;
+            }
+            // 本组已全部到达，下一轮的到达一定发生在本轮结束之后，可以直接重置
+            node.count_.store(node.expected_, std::memory_order_relaxed);
+            if (node.parent_ < 0) {
+                break;
+            }
+            index = node.parent_;
+        }
+        advance();
+        return phase;
+    }
+
+    /**
+     * 等待指定轮次结束（包括 onAdvance 执行完成）
+     * 在协程中以 Fiber::yield() 的方式等待，不占用工作线程；其他情况阻塞等待，在线程池的任务中等待时，由补偿线程接替执行其他任务
+     * @param phase
+     * @notice 等待期间不在当前栈上执行其他任务：被执行的任务若是循环等待的参与方，会与外层的参与方相互等待
+     */
+    void awaitAdvance(unsigned long phase) {
+        if (isAdvanced(phase)) {
+            return;
+        }
+        if (Fiber::inFiber()) {
+            while (!isAdvanced(phase)) {
+                Fiber::yield();
+            }
+            return;
+        }
+
+        BlockingScope scope(pool_);
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        {
+            UNIQUE_LOCK lk(mutex_);
+            cv_.wait(lk, [this, phase] { return isAdvanced(phase); });
+        }
+        waiters_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    /**
+     * 到达当前轮次，并等待本轮结束
+     * @param party
+     * @return 到达的轮次
+     */
+    unsigned long arriveAndAwait(int party) {
+        unsigned long phase = arrive(party);
+        awaitAdvance(phase);
+        return phase;
+    }
+
+    /**
+     * 获取已经结束的轮次数量
+     * @return
+     */
+    unsigned long getPhase() const {
+        return state_.load(std::memory_order_acquire) >> 1;
+    }
+
+    int getParties() const {
+        return parties_;
+    }
+
+    bool isTerminated() const {
+        return terminated_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * 获取 ThreadPool::commitPhase() 中参与方任务抛出异常的次数，可在 onAdvance 中据此决定是否终止
+     * @return
+     */
+    unsigned long getErrorNum() const {
+        return error_num_.load(std::memory_order_acquire);
+    }
+
+    NO_ALLOWED_COPY(Phaser)
+
+protected:
+    /**
+     * 按 PHASER_TREE_FANOUT 逐层构建计数器，直到只剩一个根节点
+     */
+    void buildTree() {
+        std::vector<int> levels;                                    // 每一层的节点数量
+        for (int width = parties_; ; ) {
+            width = (width + PHASER_TREE_FANOUT - 1) / PHASER_TREE_FANOUT;
+            levels.push_back(width);
+            if (1 == width) {
+                break;
+            }
+        }
+        int total = 0;
+        for (int width : levels) {
+            total += width;
+        }
+        nodes_ = std::vector<Node>(total);
+
+        int begin = 0;
+        int children = parties_;                                    // 上一层的数量，叶子节点的下一层为参与方
+        for (int width : levels) {
+            for (int i = 0; i < width; i++) {
+                Node& node = nodes_[begin + i];
+                node.expected_ = std::min(PHASER_TREE_FANOUT, children - i * PHASER_TREE_FANOUT);
+                node.count_.store(node.expected_, std::memory_order_relaxed);
+                node.parent_ = (1 == width) ? -1 : begin + width + i / PHASER_TREE_FANOUT;
+            }
+            begin += width;
+            children = width;
+        }
+    }
+
+    /**
+     * 本轮全部到达。state_ 的最低位表示正在执行 onAdvance，此时的到达属于下一轮
+     * 若下一轮在 onAdvance 结束前就已全部到达，需等待本轮的 onAdvance 结束，保证 onAdvance 按轮次依次执行
+     */
+    void advance() {
+        advancing_.fetch_add(1, std::memory_order_acq_rel);
+        unsigned long state = state_.load(std::memory_order_acquire);
+        while (state & 1) {
+            std::this_thread::yield();
+            state = state_.load(std::memory_order_acquire);
+        }
+        state_.store(state + 1, std::memory_order_seq_cst);
+        if (on_advance_ && !terminated_.load(std::memory_order_relaxed) && on_advance_(state >> 1)) {
+            terminated_.store(true, std::memory_order_release);
+        }
+        state_.store(state + 2, std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_seq_cst) > 0) {
+            LOCK_GUARD lk(mutex_);
+            cv_.notify_all();
+        }
+        advancing_.fetch_sub(1, std::memory_order_release);        // 之后不能再访问成员
+    }
+
+    bool isAdvanced(unsigned long phase) const {
+        return state_.load(std::memory_order_acquire) >= 2 * phase + 2 || isTerminated();
+    }
+
+    /**
+     * 记录参与方任务抛出的异常，在到达之前调用，保证 onAdvance 中可以读取到
+     */
+    void recordError() {
+        error_num_.fetch_add(1, std::memory_order_release);
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Node {
+        std::atomic<int> count_ {0};                                // 本轮尚未到达的数量
+        int expected_ = 0;                                          // 每轮需要到达的数量
+        int parent_ = -1;                                           // 上一层节点，根节点为-1
+    };
+
+    int parties_ = 0;
+    AdvanceCallback on_advance_;
+    ThreadPool* pool_ = nullptr;                                    // 参与方所在的线程池，用于等待时的补偿
+    std::vector<Node> nodes_;                                       // 树形计数器，叶子节点在前，根节点在最后
+    std::atomic<unsigned long> state_ {0};                          // 已结束的轮次 * 2，正在执行 onAdvance 时加1
+    std::atomic<bool> terminated_ {false};
+    std::atomic<int> waiters_ {0};                                  // 阻塞等待中的线程数量
+    std::atomic<int> advancing_ {0};                                // 正在执行 advance() 的线程数量
+    std::atomic<unsigned long> error_num_ {0};                      // 参与方任务抛出异常的次数
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    friend class ThreadPool;
+};
+
+}
+
+#endif
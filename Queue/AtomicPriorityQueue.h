@@ -2,16 +2,39 @@
 #define ATOMIC_PRIORITY_QUEUE
 
 #include "QueueObject.h"
-#include <queue>
+#include "../Utils/UtilsTicker.h"
+#include <map>
+#include <deque>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <algorithm>
+#include <functional>
 namespace ccy
 {
 
+/**
+ * 优先级队列，同一优先级内先进先出
+ * 支持老化（aging）：有效优先级 = 优先级 + min(排队时长 * 速率, 上限)，避免低优先级的元素被持续的高优先级元素饿死
+ * 元素按优先级分层存放，每层的队首即该层有效优先级最高的元素，弹出时只需比较各层的队首
+ */
 template<typename T>
 class AtomicPriorityQueue: public QueueObject{
     public:
         AtomicPriorityQueue() = default;
+
+    /**
+     * 设置老化参数
+     * @param ratePerMs 每排队1ms，提升的优先级。为0时不老化
+     * @param cap 最多提升的优先级。为0时不老化
+     * @notice 需在写入元素之前设置
+     */
+    void setAging(double ratePerMs, int cap){
+        LOCK_GUARD lk(mutex_);
+        aging_cap_ = (ratePerMs > 0 && cap > 0) ? cap : 0;
+        aging_rate_ = (0 == aging_cap_) ? 0.0 : ratePerMs * UtilsTicker::nsPerTick() / 1000000.0;
+    }
+
     /**
      * 尝试弹出
      * @param value
@@ -19,12 +42,9 @@ class AtomicPriorityQueue: public QueueObject{
      */
     bool tryPop(T& value){
         bool result = false;
-        if(mutex_.try_lock()){
-            if(!priority_queue_.empty()){
-                value = std::move(*priority_queue_.top());
-                priority_queue_.pop();
-                result = true;
-            }
+        if(0 != getApproxSize() && tryLock(mutex_)){
+            result = popLocked(value, UtilsTicker::now());
+            updateApproxSize(size_);
             mutex_.unlock();
         }
         return result;
@@ -39,12 +59,14 @@ class AtomicPriorityQueue: public QueueObject{
 
     bool tryPop(std::vector<T>& values, int maxPoolBatchSize){
         bool result = false;
-        if(mutex_.try_lock()){
-            while(!priority_queue_.empty() && maxPoolBatchSize-- > 0){
-                values.emplace_back(std::move(*priority_queue_.top()));
-                priority_queue_.pop();
+        if(0 != getApproxSize() && tryLock(mutex_)){
+            auto now = UtilsTicker::now();
+            T value;
+            while(maxPoolBatchSize-- > 0 && popLocked(value, now)){
+                values.emplace_back(std::move(value));
                 result = true;
             }
+            updateApproxSize(size_);
             mutex_.unlock();
         }
         return result;
@@ -57,26 +79,110 @@ class AtomicPriorityQueue: public QueueObject{
      * @return
      */
     void push(T&& value, int priority){
-        std::unique_ptr<T> task(c_make_unique<T>(std::move(value), priority));
+        auto now = UtilsTicker::now();
         LOCK_GUARD lk(mutex_);
-        priority_queue_.push(std::move(task));
+        levels_[priority].emplace_back(T(std::move(value), priority), now);
+        size_++;
+        updateApproxSize(size_);
     }
-     
+
     /**
      * 判定队列是否为空
      * @return
      */
     bool empty() {
         LOCK_GUARD lk(mutex_);
-        return priority_queue_.empty();
+        return 0 == size_;
     }
 
-    NO_ALLOWED_COPY(AtomicPriorityQueue)                
+    /**
+     * 获取当前排队最久的元素，已经等待的时长
+     * @return 单位为ns
+     */
+    unsigned long getMaxWait() {
+        unsigned long oldest = 0;
+        {
+            LOCK_GUARD lk(mutex_);
+            for (const auto& level : levels_) {
+                unsigned long ts = level.second.front().ts_;
+                oldest = (0 == oldest) ? ts : std::min(oldest, ts);
+            }
+        }
+        auto now = UtilsTicker::now();
+        return (0 == oldest || now <= oldest) ? 0 : UtilsTicker::toNs(now - oldest);
+    }
+
+    /**
+     * 获取历史上被弹出的元素中，等待最久的时长
+     * @return 单位为ns
+     */
+    unsigned long getPeakWait() const {
+        return UtilsTicker::toNs(peak_wait_.load(std::memory_order_relaxed));
+    }
+
+    NO_ALLOWED_COPY(AtomicPriorityQueue)
+
+    protected:
+        /**
+         * 弹出有效优先级最高的元素，有效优先级相同时，选择原始优先级较高的
+         * 从高到低遍历各层，当某层即使老化到上限也无法超过当前最优时，后续各层同样不可能，直接结束
+         * @param value
+         * @param now
+         * @return
+         * @notice 调用方需持有 mutex_
+         */
+        bool popLocked(T& value, unsigned long now){
+            if (levels_.empty()) {
+                return false;
+            }
+
+            auto best = levels_.begin();
+            double bestPriority = effective(best->first, best->second.front().ts_, now);
+            for (auto iter = std::next(levels_.begin()); iter != levels_.end(); ++iter) {
+                if (iter->first + aging_cap_ <= bestPriority) {
+                    break;
+                }
+                double cur = effective(iter->first, iter->second.front().ts_, now);
+                if (cur > bestPriority) {
+                    best = iter;
+                    bestPriority = cur;
+                }
+            }
+
+            auto& item = best->second.front();
+            if (now > item.ts_ && now - item.ts_ > peak_wait_.load(std::memory_order_relaxed)) {
+                peak_wait_.store(now - item.ts_, std::memory_order_relaxed);
+            }
+            value = std::move(item.value_);
+            best->second.pop_front();
+            if (best->second.empty()) {
+                levels_.erase(best);
+            }
+            size_--;
+            return true;
+        }
+
+        double effective(int priority, unsigned long ts, unsigned long now) const {
+            if (0 == aging_cap_ || now <= ts) {
+                return priority;
+            }
+            return priority + std::min((double)(now - ts) * aging_rate_, (double)aging_cap_);
+        }
 
     private:
-        std::priority_queue<std::unique_ptr<T>> priority_queue_;
+        struct Item {
+            Item(T&& value, unsigned long ts) : value_(std::move(value)), ts_(ts) {}
+            T value_;
+            unsigned long ts_;                                                  // 写入时的 tick
+        };
+
+        std::map<int, std::deque<Item>, std::greater<int>> levels_;            // 按优先级从高到低分层，不保留空层
+        size_t size_ = 0;
+        double aging_rate_ = 0.0;                                               // 每个 tick 提升的优先级
+        int aging_cap_ = 0;
+        std::atomic<unsigned long> peak_wait_ {0};                              // 弹出元素的最长等待，单位为 tick
 };
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -4,6 +4,7 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <vector>
 #include <condition_variable>
 #include <thread>
 #include "QueueObject.h"
@@ -22,9 +23,13 @@ class AtomicQueue: public QueueObject{
      */
     void waitPop(T& value){
         UNIQUE_LOCK lk(mutex_);
+        waiters_++;
         cv_.wait(lk, [this]{return !queue_.empty();});
+        waiters_--;
         value = std::move(*queue_.front());
         queue_.pop();
+        updateApproxSize(queue_.size());
+        chainNotify();
     }
 
     /**
@@ -34,10 +39,11 @@ class AtomicQueue: public QueueObject{
      */
     bool tryPop(T& value){
         bool result = false;
-        if (!queue_.empty() && mutex_.try_lock()) {
+        if (!queue_.empty() && tryLock(mutex_)) {
             if (!queue_.empty()) {
                 value = std::move(*queue_.front());
                 queue_.pop();
+                updateApproxSize(queue_.size());
                 result = true;
             }
             mutex_.unlock();
@@ -54,12 +60,13 @@ class AtomicQueue: public QueueObject{
      */
     bool tryPop(std::vector<T>& values, int maxPoolBatchSize) {
         bool result = false;
-        if (!queue_.empty() && mutex_.try_lock()) {
+        if (!queue_.empty() && tryLock(mutex_)) {
             while (!queue_.empty() && maxPoolBatchSize-- > 0) {
                 values.emplace_back(std::move(*queue_.front()));
                 queue_.pop();
                 result = true;
             }
+            updateApproxSize(queue_.size());
             mutex_.unlock();
         }
         return result;
@@ -72,11 +79,16 @@ class AtomicQueue: public QueueObject{
 
     std::unique_ptr<T> popWithTimeout(long ms){
         UNIQUE_LOCK lk(mutex_);
-        if(!cv_.wait_for(lk, std::chrono::milliseconds(ms), [this]{ return !queue_.empty();})){
+        waiters_++;
+        bool ready = cv_.wait_for(lk, std::chrono::milliseconds(ms), [this]{ return !queue_.empty();});
+        waiters_--;
+        if(!ready){
             return nullptr;
         }
         std::unique_ptr<T> result = std::move(queue_.front());
         queue_.pop();       // 如果等成功了，则弹出一个信息
+        updateApproxSize(queue_.size());
+        chainNotify();
         return result;
     }
 
@@ -90,6 +102,7 @@ class AtomicQueue: public QueueObject{
         if(queue_.empty()) {return std::unique_ptr<T>();}
         std::unique_ptr<T> ptr = std::move(queue_.front());
         queue_.pop();
+        updateApproxSize(queue_.size());
         return ptr;
     }
 
@@ -100,16 +113,63 @@ class AtomicQueue: public QueueObject{
     void push(T&& value){
         std::unique_ptr<typename std::remove_reference<T>::type> \
             task(c_make_unique<typename std::remove_reference<T>::type>(std::forward<T>(value)));
+        bool notify = false;
         while(true){
-            if(mutex_.try_lock()){
+            if(tryLock(mutex_)){
                 queue_.push(std::move(task));
+                updateApproxSize(queue_.size());
+                notify = waiters_ > 0;
                 mutex_.unlock();
                 break;
             }else{
                 std::this_thread::yield();
             }
         }
-        cv_.notify_one();
+        if (notify) {
+            notify_num_.fetch_add(1, std::memory_order_relaxed);
+            cv_.notify_one();
+        }
+    }
+
+    /**
+     * 批量传入数据，最多唤醒一个等待方，其余的由被唤醒方依次传递
+     * @param values
+     */
+    void push(std::vector<T>& values){
+        if (values.empty()) {
+            return;
+        }
+        std::vector<std::unique_ptr<T>> tasks;
+        tasks.reserve(values.size());
+        for (auto& value : values) {
+            tasks.emplace_back(c_make_unique<T>(std::move(value)));
+        }
+        bool notify = false;
+        while(true){
+            if(tryLock(mutex_)){
+                for (auto& task : tasks) {
+                    queue_.push(std::move(task));
+                }
+                updateApproxSize(queue_.size());
+                notify = waiters_ > 0;
+                mutex_.unlock();
+                break;
+            }else{
+                std::this_thread::yield();
+            }
+        }
+        if (notify) {
+            notify_num_.fetch_add(1, std::memory_order_relaxed);
+            cv_.notify_one();
+        }
+    }
+
+    /**
+     * 获取写入时发起唤醒的次数
+     * @return
+     */
+    unsigned long getNotifyNum() const {
+        return notify_num_.load(std::memory_order_relaxed);
     }
 
     /**
@@ -122,9 +182,23 @@ class AtomicQueue: public QueueObject{
     }
 
     NO_ALLOWED_COPY(AtomicQueue)
-    
+
+    protected:
+        /**
+         * 被唤醒的等待方取出数据后，若队列中仍有剩余，继续唤醒下一个等待方
+         * @notice 调用方需持有 mutex_
+         */
+        void chainNotify() {
+            if (!queue_.empty() && waiters_ > 0) {
+                notify_num_.fetch_add(1, std::memory_order_relaxed);
+                cv_.notify_one();
+            }
+        }
+
     private:
         std::queue<std::unique_ptr<T>> queue_;
+        int waiters_ = 0;                                               // 等待中的线程数量，修改时需持有 mutex_
+        std::atomic<unsigned long> notify_num_ {0};                     // 写入时发起唤醒的次数
 };
 
 
@@ -0,0 +1,167 @@
+#ifndef DEADLINETASKQUEUE_H
+#define DEADLINETASKQUEUE_H
+
+#include "QueueObject.h"
+#include "../Task/Task.h"
+#include "../Basic/FuncType.h"
+#include "../Utils/UtilsTicker.h"
+#include "../Utils/UtilsHistogram.h"
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+namespace ccy
+{
+
+/**
+ * 带截止时间任务统计信息的快照
+ */
+struct DeadlineTaskInfo {
+    unsigned long submit_num_ = 0;                                  // 提交的任务数量
+    unsigned long finish_num_ = 0;                                  // 执行完成的任务数量（含超时后执行的）
+    unsigned long miss_num_ = 0;                                    // 未在截止时间前完成的任务数量（含丢弃的）
+    unsigned long drop_num_ = 0;                                    // 因超时被丢弃，或改为执行回调的任务数量
+    unsigned long queue_size_ = 0;                                  // 读取时，排队中的任务数量
+    UtilsHistogramInfo lateness_;                                   // 超时任务完成（或丢弃）时，超出截止时间的耗时
+
+    /**
+     * 超时的比例
+     * @return
+     */
+    double missRate() const {
+        unsigned long done = finish_num_ + drop_num_;
+        return 0 == done ? 0.0 : (double)miss_num_ / (double)done;
+    }
+};
+
+
+/**
+ * 按截止时间排序（EDF）的任务队列，截止时间相同的任务按提交顺序执行
+ * 弹出时已经超时的任务，按照提交时指定的策略处理：照常执行、丢弃、或执行超时回调
+ */
+class DeadlineTaskQueue : public QueueObject {
+public:
+    /**
+     * 写入一个任务
+     * @param task
+     * @param deadline 截止时间，单位为 tick
+     * @param missPolicy 超时策略，参考 DEADLINE_MISS_*
+     * @param onMiss 超时回调，仅 DEADLINE_MISS_CALLBACK 策略生效，为空时等同于丢弃
+     */
+    void push(Task&& task, unsigned long deadline, int missPolicy, DEFAULT_CONST_FUNCTION_REF onMiss) {
+        LOCK_GUARD lk(mutex_);
+        heap_.emplace_back(std::move(task), deadline, seq_++, missPolicy, onMiss);
+        std::push_heap(heap_.begin(), heap_.end(), Later());
+        submit_num_.fetch_add(1, std::memory_order_relaxed);
+        updateApproxSize(heap_.size());
+    }
+
+    /**
+     * 弹出截止时间最早的任务，任务执行完成后自动统计是否超时
+     * @param task
+     * @return
+     */
+    bool tryPop(Task& task) {
+        if (0 == getApproxSize() || !tryLock(mutex_)) {
+            return false;
+        }
+
+        bool result = false;
+        std::vector<Task> dropped;                                  // 被丢弃的任务，解锁之后再析构
+        auto now = UtilsTicker::now();
+        while (!heap_.empty() && !result) {
+            std::pop_heap(heap_.begin(), heap_.end(), Later());
+            Entry entry = std::move(heap_.back());
+            heap_.pop_back();
+
+            unsigned long deadline = entry.deadline_;
+            bool expired = now > deadline;
+            if (expired && (DEADLINE_MISS_DROP == entry.policy_
+                            || (DEADLINE_MISS_CALLBACK == entry.policy_ && !entry.on_miss_))) {
+                markDrop(now - deadline);
+                dropped.emplace_back(std::move(entry.task_));
+                continue;
+            }
+
+            int tag = entry.task_.getTag();
+            unsigned long enqueueTs = entry.task_.getEnqueueTs();
+            if (expired && DEADLINE_MISS_CALLBACK == entry.policy_) {
+                markDrop(now - deadline);
+                dropped.emplace_back(std::move(entry.task_));
+                task = Task(std::move(entry.on_miss_));
+            } else {
+                task = Task([this, deadline, inner = std::move(entry.task_)]() mutable {
+                    inner();
+                    markFinish(deadline, UtilsTicker::now());
+                });
+            }
+            task.setTrace(TASK_SEGMENT_DEADLINE, tag).setEnqueueTs(enqueueTs);
+            result = true;
+        }
+        updateApproxSize(heap_.size());
+        mutex_.unlock();
+        return result;
+    }
+
+    /**
+     * 获取统计信息
+     * @param info
+     */
+    void snapshot(DeadlineTaskInfo& info) const {
+        info.submit_num_ = submit_num_.load(std::memory_order_relaxed);
+        info.finish_num_ = finish_num_.load(std::memory_order_relaxed);
+        info.miss_num_ = miss_num_.load(std::memory_order_relaxed);
+        info.drop_num_ = drop_num_.load(std::memory_order_relaxed);
+        info.queue_size_ = getApproxSize();
+        lateness_.snapshot(info.lateness_);
+    }
+
+protected:
+    void markFinish(unsigned long deadline, unsigned long end) {
+        finish_num_.fetch_add(1, std::memory_order_relaxed);
+        if (end > deadline) {
+            miss_num_.fetch_add(1, std::memory_order_relaxed);
+            lateness_.recordConcurrent(end - deadline);
+        }
+    }
+
+    void markDrop(unsigned long lateness) {
+        drop_num_.fetch_add(1, std::memory_order_relaxed);
+        miss_num_.fetch_add(1, std::memory_order_relaxed);
+        lateness_.recordConcurrent(lateness);
+    }
+
+private:
+    struct Entry {
+        Entry(Task&& task, unsigned long deadline, unsigned long seq, int policy, DEFAULT_CONST_FUNCTION_REF onMiss)
+            : task_(std::move(task)), deadline_(deadline), seq_(seq), policy_(policy), on_miss_(onMiss) {}
+
+        Task task_;
+        unsigned long deadline_;
+        unsigned long seq_;                                         // 提交顺序，截止时间相同时先进先出
+        int policy_;
+        DEFAULT_FUNCTION on_miss_;
+    };
+
+    /**
+     * 小顶堆的比较函数，截止时间晚的排在后面
+     */
+    struct Later {
+        bool operator()(const Entry& a, const Entry& b) const {
+            return a.deadline_ != b.deadline_ ? a.deadline_ > b.deadline_ : a.seq_ > b.seq_;
+        }
+    };
+
+    std::vector<Entry> heap_;
+    unsigned long seq_ = 0;
+    std::atomic<unsigned long> submit_num_ {0};
+    std::atomic<unsigned long> finish_num_ {0};
+    std::atomic<unsigned long> miss_num_ {0};
+    std::atomic<unsigned long> drop_num_ {0};
+    UtilsHistogram lateness_;
+};
+
+}
+
+#endif
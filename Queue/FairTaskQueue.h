@@ -0,0 +1,265 @@
+#ifndef FAIRTASKQUEUE_H
+#define FAIRTASKQUEUE_H
+
+#include "QueueObject.h"
+#include "../Task/Task.h"
+#include "../Utils/UtilsTicker.h"
+#include "../Utils/UtilsHistogram.h"
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+
+namespace ccy
+{
+
+/**
+ * 任务类别的句柄，由 ThreadPool::createTaskClass() 创建
+ */
+struct TaskClassHandle {
+    int index_ = -1;                                                // 类别在队列中的位置
+    std::string name_;                                              // 类别名称
+
+    bool isValid() const {
+        return index_ >= 0;
+    }
+};
+
+
+/**
+ * 任务类别统计信息的快照
+ */
+struct TaskClassInfo {
+    std::string name_;                                              // 类别名称
+    int weight_ = 0;                                                // 权重
+    int max_concurrency_ = 0;                                       // 最大并发数量，0表示不限制
+    unsigned long submit_num_ = 0;                                  // 提交的任务数量
+    unsigned long finish_num_ = 0;                                  // 执行完成的任务数量
+    unsigned long running_num_ = 0;                                 // 读取时，正在执行的任务数量
+    unsigned long queue_size_ = 0;                                  // 读取时，排队中的任务数量
+    UtilsHistogramInfo wait_;                                       // 排队耗时
+    UtilsHistogramInfo exec_;                                       // 执行耗时
+};
+
+
+/**
+ * 多类别的公平队列，按照权重分配执行时间（stride scheduling）
+ * 每个类别记录一个虚拟时间，每次弹出虚拟时间最小、且未达到并发上限的类别
+ * 任务开始时按照该类别的平均耗时预先计入，执行完成后按照实际耗时修正，耗时越长的类别，被选中的频率越低
+ * 类别由空闲变为活跃时，虚拟时间不低于当前的全局虚拟时间，避免空闲期间积累过多的额度
+ */
+class FairTaskQueue : public QueueObject {
+public:
+    /**
+     * 添加一个类别
+     * @param name
+     * @param weight 权重，必须大于0
+     * @param maxConcurrency 最大并发数量，0表示不限制
+     * @return 类别的位置，参数异常时返回-1
+     */
+    int addClass(const std::string& name, int weight, int maxConcurrency) {
+        if (weight <= 0 || maxConcurrency < 0) {
+            return -1;
+        }
+
+        LOCK_GUARD lk(mutex_);
+        for (size_t i = 0; i < classes_.size(); i++) {
+            if (classes_[i]->name_ == name) {
+                return (int)i;                              // 同名的类别，直接复用
+            }
+        }
+        std::unique_ptr<TaskClass> cls(new TaskClass());
+        cls->name_ = name;
+        cls->weight_ = weight;
+        cls->max_concurrency_ = maxConcurrency;
+        cls->pass_ = virtual_time_;
+        classes_.emplace_back(std::move(cls));
+        return (int)classes_.size() - 1;
+    }
+
+    /**
+     * 设置回调：已达到并发上限的类别，在任务执行完成后重新变为可执行时调用，用于唤醒休眠的线程
+     * @param callback
+     * @notice 需在写入任务之前设置
+     */
+    void setRunnableCallback(std::function<void()> callback) {
+        on_runnable_ = std::move(callback);
+    }
+
+    /**
+     * 获取可以立即弹出的任务的大致数量，不包含已达到并发上限的类别中的任务
+     * @return
+     */
+    size_t getRunnableSize() const {
+        return runnable_size_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * 写入一个任务
+     * @param index 类别的位置
+     * @param task
+     * @return 类别不存在时，返回false
+     */
+    bool push(int index, Task&& task) {
+        LOCK_GUARD lk(mutex_);
+        if (unlikely(index < 0 || index >= (int)classes_.size())) {
+            return false;
+        }
+
+        auto& cls = *classes_[index];
+        if (cls.queue_.empty() && 0 == cls.running_) {
+            cls.pass_ = std::max(cls.pass_, virtual_time_);
+        }
+        cls.queue_.emplace_back(std::move(task));
+        cls.submit_num_.fetch_add(1, std::memory_order_relaxed);
+        updateApproxSize(getApproxSize() + 1);
+        if (!isCapped(cls)) {
+            updateRunnableSize(1);
+        }
+        return true;
+    }
+
+    /**
+     * 尝试弹出一个任务。弹出的任务执行完成后，会自动修正所属类别的虚拟时间和并发数量
+     * @param task
+     * @return
+     */
+    bool tryPop(Task& task) {
+        if (0 == getRunnableSize() || !tryLock(mutex_)) {
+            return false;
+        }
+
+        int picked = -1;
+        for (size_t i = 0; i < classes_.size(); i++) {
+            auto& cls = *classes_[i];
+            if (cls.queue_.empty() || isCapped(cls)) {
+                continue;
+            }
+            if (picked < 0 || cls.pass_ < classes_[picked]->pass_) {
+                picked = (int)i;
+            }
+        }
+
+        if (picked >= 0) {
+            auto& cls = *classes_[picked];
+            Task inner = std::move(cls.queue_.front());
+            cls.queue_.pop_front();
+            cls.running_++;
+            // 弹出的任务不再计入；达到并发上限时，剩余的任务也不再可执行
+            updateRunnableSize(isCapped(cls) ? -1 - (long)cls.queue_.size() : -1);
+            virtual_time_ = std::max(virtual_time_, cls.pass_);
+            double charge = cls.est_cost_ / cls.weight_;
+            cls.pass_ += charge;
+            updateApproxSize(getApproxSize() - 1);
+
+            int tag = inner.getTag();
+            unsigned long enqueueTs = inner.getEnqueueTs();
+            task = Task([this, picked, charge, enqueueTs, inner = std::move(inner)]() mutable {
+                auto start = UtilsTicker::now();
+                inner();
+                auto end = UtilsTicker::now();
+                finish(picked, charge, start > enqueueTs ? start - enqueueTs : 0, end - start);
+            });
+            task.setTrace(TASK_SEGMENT_FAIR, tag).setEnqueueTs(enqueueTs);     // 保留原任务的入队时间，用于统计排队耗时
+        }
+        mutex_.unlock();
+        return picked >= 0;
+    }
+
+    /**
+     * 获取所有类别的统计信息
+     * @param infos
+     */
+    void snapshot(std::vector<TaskClassInfo>& infos) {
+        LOCK_GUARD lk(mutex_);
+        infos.resize(classes_.size());
+        for (size_t i = 0; i < classes_.size(); i++) {
+            auto& cls = *classes_[i];
+            auto& info = infos[i];
+            info.name_ = cls.name_;
+            info.weight_ = cls.weight_;
+            info.max_concurrency_ = cls.max_concurrency_;
+            info.submit_num_ = cls.submit_num_.load(std::memory_order_relaxed);
+            info.finish_num_ = cls.finish_num_.load(std::memory_order_relaxed);
+            info.running_num_ = (unsigned long)cls.running_;
+            info.queue_size_ = cls.queue_.size();
+            cls.wait_.snapshot(info.wait_);
+            cls.exec_.snapshot(info.exec_);
+        }
+    }
+
+protected:
+    /**
+     * 任务执行完成，按照实际耗时修正虚拟时间，并更新平均耗时
+     * @param index
+     * @param charge 开始时预先计入的虚拟时间
+     * @param waitTicks
+     * @param execTicks
+     */
+    void finish(int index, double charge, unsigned long waitTicks, unsigned long execTicks) {
+        bool released = false;
+        {
+            LOCK_GUARD lk(mutex_);
+            auto& cls = *classes_[index];
+            bool capped = isCapped(cls);
+            cls.running_--;
+            if (capped && !cls.queue_.empty()) {
+                updateRunnableSize((long)cls.queue_.size());       // 释放了一个并发名额，排队中的任务重新变为可执行
+                released = true;
+            }
+            cls.pass_ += (double)execTicks / cls.weight_ - charge;
+            cls.est_cost_ = cls.est_cost_ * 0.875 + (double)execTicks * 0.125;
+            cls.finish_num_.fetch_add(1, std::memory_order_relaxed);
+            cls.wait_.record(waitTicks);                    // 持有锁，可以使用单线程写入的方式
+            cls.exec_.record(execTicks);
+        }
+        if (released && on_runnable_) {
+            on_runnable_();
+        }
+    }
+
+private:
+    struct TaskClass {
+        std::string name_;
+        int weight_ = 1;
+        int max_concurrency_ = 0;
+        std::deque<Task> queue_;                                    // 排队中的任务
+        int running_ = 0;                                           // 正在执行的任务数量
+        double pass_ = 0.0;                                         // 虚拟时间，单位为 tick / 权重
+        double est_cost_ = 1000.0;                                  // 平均执行耗时，单位为 tick
+        std::atomic<unsigned long> submit_num_ {0};
+        std::atomic<unsigned long> finish_num_ {0};
+        UtilsHistogram wait_;
+        UtilsHistogram exec_;
+    };
+
+    /**
+     * 类别是否已达到并发上限，需要在持有锁的时候调用
+     * @param cls
+     * @return
+     */
+    static bool isCapped(const TaskClass& cls) {
+        return cls.max_concurrency_ > 0 && cls.running_ >= cls.max_concurrency_;
+    }
+
+    /**
+     * 更新可执行任务的数量，需要在持有锁的时候调用
+     * @param delta
+     */
+    void updateRunnableSize(long delta) {
+        runnable_size_.store((size_t)((long)getRunnableSize() + delta), std::memory_order_relaxed);
+    }
+
+    std::vector<std::unique_ptr<TaskClass>> classes_;               // 所有类别，只增不减
+    double virtual_time_ = 0.0;                                     // 全局虚拟时间，即最近被选中类别的虚拟时间
+    std::atomic<size_t> runnable_size_ {0};                         // 未达到并发上限的类别中，排队任务的数量
+    std::function<void()> on_runnable_;                             // 类别重新变为可执行时的回调
+};
+
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef LOCKFREEMPSCQUEUE_H
+#define LOCKFREEMPSCQUEUE_H
+
+#include "QueueObject.h"
+#include <atomic>
+#include <memory>
+
+namespace ccy
+{
+
+/**
+ * 无锁链表队列（Vyukov MPSC），先进先出
+ * push 为 wait-free，仅一次原子交换
+ * @notice 支持多生产者、单消费者。生产者交换头节点后、链接前被打断时，消费者会暂时看不到之后写入的元素
+ */
+template<typename T>
+class LockFreeMpscQueue: public QueueObject{
+    public:
+        explicit LockFreeMpscQueue(){
+            auto* stub = new Node();
+            head_.store(stub, std::memory_order_relaxed);
+            tail_ = stub;
+        }
+
+        ~LockFreeMpscQueue() override{
+            while (nullptr != tail_) {
+                Node* next = tail_->next_.load(std::memory_order_relaxed);
+                delete tail_;
+                tail_ = next;
+            }
+        }
+
+        /**
+         * 写入一个元素，可以被多个线程同时调用
+         * @param value
+         */
+        void push(T&& value){
+            auto* node = new Node();
+            node->value_ = c_make_unique<T>(std::move(value));
+            Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+            prev->next_.store(node, std::memory_order_release);
+        }
+
+        /**
+         * 尝试弹出一个元素，仅允许单一消费者调用
+         * @param value
+         * @return
+         */
+        bool tryPop(T& value){
+            Node* tail = tail_;
+            Node* next = tail->next_.load(std::memory_order_acquire);
+            if(nullptr == next){
+                return false;
+            }
+
+            value = std::move(*next->value_);
+            next->value_.reset();                  // next 成为新的哨兵节点
+            tail_ = next;
+            delete tail;
+            return true;
+        }
+
+        /**
+         * 判断是否为空，仅允许消费者调用
+         * @return
+         */
+        bool empty() const {
+            return nullptr == tail_->next_.load(std::memory_order_acquire);
+        }
+
+        NO_ALLOWED_COPY(LockFreeMpscQueue)
+
+    private:
+        struct Node {
+            std::atomic<Node*> next_ {nullptr};
+            std::unique_ptr<T> value_;
+        };
+
+        std::atomic<Node*> head_;                              // 最近写入的节点，由生产者交换
+        Node* tail_;                                           // 哨兵节点，仅消费者访问
+};
+
+}
+
+#endif
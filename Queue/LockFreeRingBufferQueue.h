@@ -9,6 +9,10 @@
 namespace ccy
 {
 
+/**
+ * 无锁环形队列
+ * @notice 仅支持单生产者、单消费者
+ */
 template<typename T, int CAPACITY = DEFAULT_ATOMICRING_SIZE>
 class LockFreeRingBufferQueue: public QueueObject{
     public:
@@ -34,7 +38,7 @@ class LockFreeRingBufferQueue: public QueueObject{
                 // 队列已满，等待其他线程出队
                 std::this_thread::yield();
             }
-            ring_buffer_[curTail] = std::move(value);
+            ring_buffer_[curTail] = c_make_unique<T>(std::move(value));
             tail_.store(nextTail, std::memory_order_release);
         }
 
@@ -50,7 +54,7 @@ class LockFreeRingBufferQueue: public QueueObject{
                 return false;
             }
 
-            value = std::move(ring_buffer_[curHead]);
+            value = std::move(*ring_buffer_[curHead]);
             int nextHead = (curHead + 1) % CAPACITY;
             head_.store(nextHead, std::memory_order_release);
             return true;
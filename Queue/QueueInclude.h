@@ -6,5 +6,9 @@
 #include "AtomicPriorityQueue.h"
 #include "AtomicRingBufferQueue.h"
 #include "LockFreeRingBufferQueue.h"
+#include "LockFreeMpscQueue.h"
+#include "FairTaskQueue.h"
+#include "DeadlineTaskQueue.h"
+#include "SharedMemoryQueue.h"
 
 #endif 
\ No newline at end of file
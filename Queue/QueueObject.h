@@ -5,6 +5,7 @@
 #include "QueueDefine.h"
 
 #include <mutex>
+#include <atomic>
 #include <condition_variable>
 
 
@@ -12,9 +13,68 @@ namespace ccy
 {
 
 class QueueObject: public ThreadObject{
+    public:
+        /**
+         * 获取队列中元素的大致数量，无锁读取，仅用于统计
+         * @return
+         */
+        size_t getApproxSize() const {
+            return approx_size_.load(std::memory_order_relaxed);
+        }
+
+#ifdef _ENABLE_QUEUE_PROFILE_
+        /**
+         * 获取 try_lock 的总次数
+         * @return
+         */
+        unsigned long getTryLockNum() const {
+            return try_lock_num_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * 获取 try_lock 失败的次数
+         * @return
+         */
+        unsigned long getTryLockFailNum() const {
+            return try_lock_fail_num_.load(std::memory_order_relaxed);
+        }
+#endif
+
+    protected:
+        /**
+         * 更新队列的大致数量，需要在持有锁的时候调用
+         * @param size
+         */
+        void updateApproxSize(size_t size) {
+            approx_size_.store(size, std::memory_order_relaxed);
+        }
+
+        /**
+         * 尝试加锁。开启 _ENABLE_QUEUE_PROFILE_ 时，记录失败次数
+         * @param mtx
+         * @return
+         */
+        bool tryLock(std::mutex& mtx) {
+            bool result = mtx.try_lock();
+#ifdef _ENABLE_QUEUE_PROFILE_
+            try_lock_num_.fetch_add(1, std::memory_order_relaxed);
+            if (!result) {
+                try_lock_fail_num_.fetch_add(1, std::memory_order_relaxed);
+            }
+#endif
+            return result;
+        }
+
     protected:
         std::mutex mutex_;
         std::condition_variable cv_;
+
+    private:
+        std::atomic<size_t> approx_size_ {0};                           // 队列中元素的大致数量
+#ifdef _ENABLE_QUEUE_PROFILE_
+        std::atomic<unsigned long> try_lock_num_ {0};                  // try_lock 的次数
+        std::atomic<unsigned long> try_lock_fail_num_ {0};             // try_lock 失败的次数
+#endif
 };
 
 }
@@ -0,0 +1,330 @@
+#ifndef SHAREDMEMORYQUEUE_H
+#define SHAREDMEMORYQUEUE_H
+
+#include "QueueObject.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <ctime>
+#include <atomic>
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+namespace ccy
+{
+
+/**
+ * 跨进程传递的任务描述，定长，可以直接按字节拷贝
+ */
+struct SharedTaskDesc {
+    unsigned int func_id_ = 0;                                      // 任务类型，由生产方和消费方约定
+    unsigned int size_ = 0;                                         // payload_ 中有效数据的长度
+    char payload_[SHARED_TASK_PAYLOAD_SIZE] = {0};                  // 内联的参数
+};
+
+
+/**
+ * 基于共享内存的有界 MPMC 环形队列，可在多个进程之间同时读写
+ * 每个槽位带有序号（参考 Vyukov 的有界 MPMC 队列），生产方和消费方各自通过 CAS 抢占位置，无需加锁
+ * 队列为空时，消费方通过 futex 休眠，生产方仅在有消费方休眠时才发起唤醒
+ * @notice 共享内存中只能存放定长的数据，不能存放指针
+ */
+class SharedMemoryQueue : public QueueObject {
+public:
+    SharedMemoryQueue() = default;
+
+    ~SharedMemoryQueue() override {
+        close();
+    }
+
+    /**
+     * 创建队列
+     * @param name 为空时通过 memfd 创建匿名的共享内存，可通过 fork 或传递 fd 共享；否则通过 shm_open 创建具名的共享内存
+     * @param capacity 容量，向上取整为2的幂
+     * @return
+     */
+    Status create(const std::string& name, unsigned int capacity) {
+        Status status;
+        RETURN_ERROR_STATUS_BY_CONDITION(nullptr != header_, "shared queue is already open")
+        RETURN_ERROR_STATUS_BY_CONDITION(0 == capacity, "shared queue capacity cannot be 0")
+
+        unsigned int size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        int fd = name.empty() ? (int)syscall(SYS_memfd_create, "ccy_shared_queue", 0)
+                              : shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        RETURN_ERROR_STATUS_BY_CONDITION(fd < 0, "shared memory create failed")
+        size_t bytes = sizeof(Header) + (size_t)size * sizeof(Slot);
+        if (0 != ftruncate(fd, (off_t)bytes) || !map(fd, bytes)) {
+            ::close(fd);
+            RETURN_ERROR_STATUS("shared memory map failed")
+        }
+
+        // 新建的共享内存已经清零，只需写入槽位的初始序号
+        header_->capacity_ = size;
+        for (unsigned int i = 0; i < size; i++) {
+            slots_[i].seq_.store(i, std::memory_order_relaxed);
+        }
+        header_->magic_.store(SHARED_QUEUE_MAGIC, std::memory_order_release);
+        return status;
+    }
+
+    /**
+     * 打开其他进程通过 create() 创建的具名队列
+     * @param name
+     * @return
+     */
+    Status open(const std::string& name) {
+        Status status;
+        RETURN_ERROR_STATUS_BY_CONDITION(nullptr != header_, "shared queue is already open")
+        int fd = shm_open(name.c_str(), O_RDWR, 0600);
+        RETURN_ERROR_STATUS_BY_CONDITION(fd < 0, "shared memory open failed")
+        return attach(fd);
+    }
+
+    /**
+     * 通过已有的 fd 打开队列，如从其他进程传递来的 memfd
+     * @param fd 成功后由本队列负责关闭
+     * @return
+     */
+    Status attach(int fd) {
+        Status status;
+        struct stat st {};
+        if (0 != fstat(fd, &st) || (size_t)st.st_size < sizeof(Header) || !map(fd, (size_t)st.st_size)) {
+            ::close(fd);
+            RETURN_ERROR_STATUS("shared memory map failed")
+        }
+        if (SHARED_QUEUE_MAGIC != header_->magic_.load(std::memory_order_acquire)
+            || sizeof(Header) + (size_t)header_->capacity_ * sizeof(Slot) > mapped_size_) {
+            close();
+            RETURN_ERROR_STATUS("shared memory is not a shared queue")
+        }
+        return status;
+    }
+
+    /**
+     * 解除映射。不会删除具名的共享内存，参考 unlink()
+     */
+    void close() {
+        if (nullptr != header_) {
+            munmap(header_, mapped_size_);
+            header_ = nullptr;
+            slots_ = nullptr;
+            mapped_size_ = 0;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    /**
+     * 删除具名的共享内存，已经打开的队列不受影响
+     * @param name
+     */
+    static void unlink(const std::string& name) {
+        shm_unlink(name.c_str());
+    }
+
+    /**
+     * 获取共享内存的 fd，可通过 fork 或 SCM_RIGHTS 传递给其他进程
+     * @return
+     */
+    int getFd() const {
+        return fd_;
+    }
+
+    /**
+     * 尝试写入一个任务描述
+     * @param funcId
+     * @param payload
+     * @param size 不能超过 SHARED_TASK_PAYLOAD_SIZE
+     * @return 队列已满或参数异常时，返回 false
+     */
+    bool tryPush(unsigned int funcId, const void* payload, unsigned int size) {
+        if (unlikely(size > SHARED_TASK_PAYLOAD_SIZE)) {
+            return false;
+        }
+
+        unsigned long mask = header_->capacity_ - 1;
+        unsigned long pos = header_->enqueue_pos_.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        while (true) {
+            slot = &slots_[pos & mask];
+            unsigned long seq = slot->seq_.load(std::memory_order_acquire);
+            long diff = (long)seq - (long)pos;
+            if (0 == diff) {
+                if (header_->enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;       // 槽位尚未被消费，队列已满
+            } else {
+                pos = header_->enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->desc_.func_id_ = funcId;
+        slot->desc_.size_ = size;
+        if (size > 0) {
+            memcpy(slot->desc_.payload_, payload, size);
+        }
+        slot->seq_.store(pos + 1, std::memory_order_release);
+        notify();
+        return true;
+    }
+
+    /**
+     * 写入一个任务描述，队列已满时等待
+     * @param funcId
+     * @param payload
+     * @param size
+     * @return 参数异常时，返回 false
+     */
+    bool push(unsigned int funcId, const void* payload, unsigned int size) {
+        if (unlikely(size > SHARED_TASK_PAYLOAD_SIZE)) {
+            return false;
+        }
+        while (!tryPush(funcId, payload, size)) {
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    /**
+     * 尝试弹出一个任务描述
+     * @param desc
+     * @return
+     */
+    bool tryPop(SharedTaskDesc& desc) {
+        unsigned long mask = header_->capacity_ - 1;
+        unsigned long pos = header_->dequeue_pos_.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        while (true) {
+            slot = &slots_[pos & mask];
+            unsigned long seq = slot->seq_.load(std::memory_order_acquire);
+            long diff = (long)seq - (long)(pos + 1);
+            if (0 == diff) {
+                if (header_->dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;       // 槽位尚未写入，队列为空
+            } else {
+                pos = header_->dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        memcpy(&desc, &slot->desc_, sizeof(SharedTaskDesc));
+        slot->seq_.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * 队列为空时休眠，直到有新的写入、被 wakeAll() 唤醒、或超时
+     * @param timeoutMs
+     */
+    void wait(long timeoutMs) {
+        unsigned int ver = header_->version_.load(std::memory_order_seq_cst);
+        header_->waiters_.fetch_add(1, std::memory_order_seq_cst);
+        if (empty()) {
+            // 写入方先发布数据、再修改 version_；若在读取 ver 之后发生了写入，futex 会立即返回
+            timespec ts { timeoutMs / 1000, (timeoutMs % 1000) * 1000000 };
+            futex(&header_->version_, FUTEX_WAIT, ver, &ts);
+        }
+        header_->waiters_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    /**
+     * 唤醒所有休眠中的消费方
+     */
+    void wakeAll() {
+        header_->version_.fetch_add(1, std::memory_order_seq_cst);
+        futex(&header_->version_, FUTEX_WAKE, INT32_MAX, nullptr);
+    }
+
+    /**
+     * 判断是否为空，结果仅供参考
+     * @return
+     */
+    bool empty() const {
+        unsigned long pos = header_->dequeue_pos_.load(std::memory_order_acquire);
+        unsigned long seq = slots_[pos & (header_->capacity_ - 1)].seq_.load(std::memory_order_acquire);
+        return (long)seq - (long)(pos + 1) < 0;
+    }
+
+    /**
+     * 获取容量
+     * @return
+     */
+    unsigned int getCapacity() const {
+        return nullptr == header_ ? 0 : header_->capacity_;
+    }
+
+    NO_ALLOWED_COPY(SharedMemoryQueue)
+
+protected:
+    bool map(int fd, size_t bytes) {
+        void* ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (MAP_FAILED == ptr) {
+            return false;
+        }
+        fd_ = fd;
+        mapped_size_ = bytes;
+        header_ = (Header*)ptr;
+        slots_ = (Slot*)((char*)ptr + sizeof(Header));
+        return true;
+    }
+
+    /**
+     * 写入后，仅在有消费方休眠时发起唤醒
+     */
+    void notify() {
+        header_->version_.fetch_add(1, std::memory_order_seq_cst);
+        if (header_->waiters_.load(std::memory_order_seq_cst) > 0) {
+            futex(&header_->version_, FUTEX_WAKE, 1, nullptr);
+        }
+    }
+
+    /**
+     * 跨进程使用，不能设置 FUTEX_PRIVATE_FLAG
+     */
+    static long futex(std::atomic<unsigned int>* addr, int op, unsigned int val, const timespec* ts) {
+        return syscall(SYS_futex, (unsigned int*)addr, op, val, ts, nullptr, 0);
+    }
+
+private:
+    struct Header {
+        std::atomic<unsigned long> magic_;
+        unsigned int capacity_;
+        alignas(CACHE_LINE_SIZE) std::atomic<unsigned long> enqueue_pos_;
+        alignas(CACHE_LINE_SIZE) std::atomic<unsigned long> dequeue_pos_;
+        alignas(CACHE_LINE_SIZE) std::atomic<unsigned int> version_;        // 每次写入后加1，作为 futex 的等待地址
+        std::atomic<unsigned int> waiters_;                                  // 休眠中的消费方数量
+    };
+
+    struct Slot {
+        std::atomic<unsigned long> seq_;
+        SharedTaskDesc desc_;
+    };
+
+    static_assert(sizeof(std::atomic<unsigned long>) == sizeof(unsigned long)
+                  && std::atomic<unsigned long>::is_always_lock_free
+                  && std::atomic<unsigned int>::is_always_lock_free,
+                  "shared queue requires address-free atomics");
+
+    Header* header_ = nullptr;
+    Slot* slots_ = nullptr;
+    size_t mapped_size_ = 0;
+    int fd_ = -1;
+};
+
+}
+
+#endif
@@ -16,8 +16,9 @@ class WorkStealingQueue: public QueueObject{
          */
         void push(T&& task){
             while(true){
-                if(lock_.try_lock()){
+                if(tryLock(lock_)){
                     deque_.emplace_front(std::forward<T>(task));
+                    updateApproxSize(deque_.size());
                     lock_.unlock();
                     break;
                 }else{
@@ -33,8 +34,9 @@ class WorkStealingQueue: public QueueObject{
          */
         bool tryPush(T&& task){
             bool result = false;
-            if(lock_.try_lock()){
+            if(tryLock(lock_)){
                 deque_.emplace_back(std::forward<T>(task));
+                updateApproxSize(deque_.size());
                 lock_.unlock();
                 result = true;
             }
@@ -47,10 +49,11 @@ class WorkStealingQueue: public QueueObject{
          */
         void push(std::vector<T>& tasks){
             while(true){
-                if(lock_.try_lock()){
-                    for(const auto& task: tasks){
+                if(tryLock(lock_)){
+                    for(auto& task: tasks){
                         deque_.emplace_front(std::forward<T>(task));
                     }
+                    updateApproxSize(deque_.size());
                     lock_.unlock();
                     break;
                 }else{
@@ -67,10 +70,11 @@ class WorkStealingQueue: public QueueObject{
 
         bool tryPush(std::vector<T>& tasks) {
             bool result = false;
-            if (lock_.try_lock()) {
-                for (const auto& task : tasks) {
+            if (tryLock(lock_)) {
+                for (auto& task : tasks) {
                     deque_.emplace_back(std::forward<T>(task));
                 }
+                updateApproxSize(deque_.size());
                 lock_.unlock();
                 result = true;
             }
@@ -84,12 +88,13 @@ class WorkStealingQueue: public QueueObject{
          */
         bool tryPop(T& task) {
             bool result = false;
-            if (!deque_.empty() && lock_.try_lock()) {
+            if (!deque_.empty() && tryLock(lock_)) {
                 if (!deque_.empty()) {
                     task = std::forward<T>(deque_.front());    // 从前方弹出
                     deque_.pop_front();
                     result = true;
                 }
+                updateApproxSize(deque_.size());
                 lock_.unlock();
             }
 
@@ -104,12 +109,13 @@ class WorkStealingQueue: public QueueObject{
          */
         bool tryPop(std::vector<T>& taskArr, int maxLocalBatchSize) {
             bool result = false;
-            if (!deque_.empty() && lock_.try_lock()) {
+            if (!deque_.empty() && tryLock(lock_)) {
                 while (!deque_.empty() && maxLocalBatchSize--) {
                     taskArr.emplace_back(std::forward<T>(deque_.front()));
                     deque_.pop_front();
                     result = true;
                 }
+                updateApproxSize(deque_.size());
                 lock_.unlock();
             }
 
@@ -122,12 +128,13 @@ class WorkStealingQueue: public QueueObject{
          */
         bool trySteal(T& task) {
             bool result = false;
-            if (!deque_.empty() && lock_.try_lock()) {
+            if (!deque_.empty() && tryLock(lock_)) {
                 if (!deque_.empty()) {
                     task = std::forward<T>(deque_.back());    // 从后方窃取
                     deque_.pop_back();
                     result = true;
                 }
+                updateApproxSize(deque_.size());
                 lock_.unlock();
             }
 
@@ -142,12 +149,13 @@ class WorkStealingQueue: public QueueObject{
          */
         bool trySteal(std::vector<T>& taskArr, int maxStealBatchSize) {
             bool result = false;
-            if (!deque_.empty() && lock_.try_lock()) {
+            if (!deque_.empty() && tryLock(lock_)) {
                 while (!deque_.empty() && maxStealBatchSize--) {
                     taskArr.emplace_back(std::forward<T>(deque_.back()));
                     deque_.pop_back();
                     result = true;
                 }
+                updateApproxSize(deque_.size());
                 lock_.unlock();
             }
 
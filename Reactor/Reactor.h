@@ -0,0 +1,360 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include "../ThreadPool.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+namespace ccy
+{
+
+/**
+ * fd 就绪时的回调
+ * @param fd 就绪的 fd
+ * @param events 就绪的事件，参考 EPOLLIN / EPOLLOUT 等
+ */
+using ReactorCallback = std::function<void(int fd, unsigned int events)>;
+
+/**
+ * reactor 统计信息的快照
+ */
+struct ReactorInfo {
+    unsigned long fd_num_ = 0;                                      // 读取时，注册中的 fd 数量
+    unsigned long poll_num_ = 0;                                    // epoll_wait 返回的次数
+    unsigned long event_num_ = 0;                                   // 分发到主线程的就绪事件数量
+    unsigned long wakeup_num_ = 0;                                  // 通过 wakeup() 唤醒的次数
+    unsigned long error_num_ = 0;                                   // 回调抛出异常的次数
+};
+
+
+/**
+ * 基于 epoll 的 reactor，由线程池持有
+ * 就绪事件直接写入主线程的本地队列执行回调，无需经过 pool 的队列和额外的事件循环
+ * fd 以 EPOLLONESHOT 方式注册：同一个 fd 的回调同一时刻最多只有一个在执行，回调返回后自动重新监听
+ * 多个 reactor 线程共用同一个 epoll 实例，通过 eventfd 实现跨线程的唤醒
+ * @notice 推荐通过 ThreadPool::getReactor() 获取，需开启 reactor_thread_size_
+ */
+class Reactor {
+public:
+    explicit Reactor(ThreadPool* pool) {
+        pool_ = pool;
+    }
+
+    ~Reactor() {
+        destroy();
+    }
+
+    /**
+     * 创建 epoll 实例和唤醒用的 eventfd，并启动 reactor 线程
+     * @param threadSize reactor 线程数量
+     * @return
+     */
+    Status init(int threadSize) {
+        Status status;
+        if (epoll_fd_ >= 0) {
+            return status;
+        }
+        RETURN_ERROR_STATUS_BY_CONDITION(threadSize <= 0, "reactor thread size cannot less than 1")
+
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        RETURN_ERROR_STATUS_BY_CONDITION(epoll_fd_ < 0, "epoll create failed")
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wake_fd_ < 0) {
+            closeFd();
+            RETURN_ERROR_STATUS("eventfd create failed")
+        }
+
+        // 唤醒用的 eventfd 水平触发，停止时所有 reactor 线程都能被唤醒
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.u64 = WAKEUP_KEY;
+        if (0 != epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event)) {
+            closeFd();
+            RETURN_ERROR_STATUS("eventfd register failed")
+        }
+
+        stop_.store(false, std::memory_order_release);
+        for (int i = 0; i < threadSize; i++) {
+            threads_.emplace_back(&Reactor::loop, this);
+        }
+        return status;
+    }
+
+    /**
+     * 停止 reactor 线程，并释放 epoll 实例。注册的 fd 不会被关闭
+     * @return
+     * @notice 已经分发到主线程的回调仍会执行
+     */
+    Status destroy() {
+        Status status;
+        if (epoll_fd_ < 0) {
+            return status;
+        }
+
+        stop_.store(true, std::memory_order_release);
+        notify();
+        for (auto& thd : threads_) {
+            if (thd.joinable()) {
+                thd.join();
+            }
+        }
+        threads_.clear();
+        {
+            LOCK_GUARD lk(mutex_);
+            handlers_.clear();
+        }
+        closeFd();
+        return status;
+    }
+
+    /**
+     * 注册 fd。就绪时，回调在主线程中执行，同一个 fd 固定分发给同一个主线程
+     * @param fd 建议设置为非阻塞
+     * @param events 关注的事件，如 EPOLLIN | EPOLLOUT，无需设置 EPOLLONESHOT
+     * @param callback
+     * @param tag 用户自定义标签，用于分类统计延迟信息
+     * @return
+     * @notice 回调中需读完（或写完）就绪的数据，否则返回后会立即再次触发。回调抛出的异常会被忽略，计入 error_num_，之后仍会重新监听
+     */
+    Status add(int fd, unsigned int events, ReactorCallback callback, int tag = DEFAULT_TASK_TAG) {
+        Status status;
+        RETURN_ERROR_STATUS_BY_CONDITION(epoll_fd_ < 0, "reactor is not init")
+        RETURN_ERROR_STATUS_BY_CONDITION(fd < 0 || !callback, "reactor fd or callback is invalid")
+
+        auto handler = std::make_shared<Handler>();
+        handler->fd_ = fd;
+        handler->events_ = events;
+        handler->tag_ = tag;
+        handler->callback_ = std::move(callback);
+
+        LOCK_GUARD lk(mutex_);
+        RETURN_ERROR_STATUS_BY_CONDITION(handlers_.count(fd) > 0, "reactor fd is already registered")
+        handler->key_ = makeKey(fd, ++serial_);
+        handler->slot_ = slot_++;
+        epoll_event event {};
+        event.events = events | EPOLLONESHOT;
+        event.data.u64 = handler->key_;
+        RETURN_ERROR_STATUS_BY_CONDITION(0 != epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event),
+                                         "reactor fd register failed")
+        handlers_[fd] = std::move(handler);
+        return status;
+    }
+
+    /**
+     * 修改 fd 关注的事件。回调执行中时，在回调返回后生效
+     * @param fd
+     * @param events
+     * @return
+     */
+    Status modify(int fd, unsigned int events) {
+        Status status;
+        LOCK_GUARD lk(mutex_);
+        auto iter = handlers_.find(fd);
+        RETURN_ERROR_STATUS_BY_CONDITION(iter == handlers_.end(), "reactor fd is not registered")
+        iter->second->events_ = events;
+        if (!iter->second->running_) {
+            RETURN_ERROR_STATUS_BY_CONDITION(!arm(*iter->second), "reactor fd modify failed")
+        }
+        return status;
+    }
+
+    /**
+     * 取消注册 fd，之后才可以关闭该 fd
+     * @param fd
+     * @return
+     * @notice 已经分发、或正在执行的回调仍会执行完，但不会再重新监听
+     */
+    Status remove(int fd) {
+        Status status;
+        LOCK_GUARD lk(mutex_);
+        auto iter = handlers_.find(fd);
+        RETURN_ERROR_STATUS_BY_CONDITION(iter == handlers_.end(), "reactor fd is not registered")
+        handlers_.erase(iter);
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        return status;
+    }
+
+    /**
+     * 唤醒一个阻塞在 epoll_wait 中的 reactor 线程，可在任意线程中调用
+     */
+    void wakeup() {
+        wakeup_num_.fetch_add(1, std::memory_order_relaxed);
+        notify();
+    }
+
+    /**
+     * 获取统计信息
+     * @param info
+     */
+    void snapshot(ReactorInfo& info) {
+        {
+            LOCK_GUARD lk(mutex_);
+            info.fd_num_ = handlers_.size();
+        }
+        info.poll_num_ = poll_num_.load(std::memory_order_relaxed);
+        info.event_num_ = event_num_.load(std::memory_order_relaxed);
+        info.wakeup_num_ = wakeup_num_.load(std::memory_order_relaxed);
+        info.error_num_ = error_num_.load(std::memory_order_relaxed);
+    }
+
+    NO_ALLOWED_COPY(Reactor)
+
+protected:
+    struct Handler {
+        int fd_ = -1;
+        unsigned int events_ = 0;                                   // 关注的事件，不含 EPOLLONESHOT
+        int tag_ = DEFAULT_TASK_TAG;
+        unsigned long key_ = 0;                                     // 写入 epoll_event 的标识，区分复用同一个 fd 的注册
+        unsigned int slot_ = 0;                                     // 注册序号，用于选择执行回调的主线程
+        bool running_ = false;                                      // 回调是否已分发且尚未返回，修改时需持有 mutex_
+        ReactorCallback callback_;
+    };
+
+    /**
+     * reactor 线程执行函数
+     */
+    void loop() {
+        epoll_event events[REACTOR_MAX_EVENTS];
+        while (!stop_.load(std::memory_order_acquire)) {
+            int num = epoll_wait(epoll_fd_, events, REACTOR_MAX_EVENTS, -1);
+            if (num < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                break;
+            }
+
+            poll_num_.fetch_add(1, std::memory_order_relaxed);
+            for (int i = 0; i < num; i++) {
+                if (WAKEUP_KEY == events[i].data.u64) {
+                    if (stop_.load(std::memory_order_acquire)) {
+                        return;     // 不读取 eventfd，保持就绪，唤醒其他 reactor 线程
+                    }
+                    eventfd_t value = 0;
+                    eventfd_read(wake_fd_, &value);
+                    continue;
+                }
+                dispatch(events[i].data.u64, events[i].events);
+            }
+        }
+    }
+
+    /**
+     * 析构时重新监听 fd，保证回调无论正常返回还是抛出异常，都不会遗漏 rearm()
+     */
+    struct RearmGuard {
+        Reactor* reactor_;
+        const std::shared_ptr<Handler>& handler_;
+        ~RearmGuard() {
+            reactor_->rearm(handler_);
+        }
+    };
+
+    /**
+     * 将就绪事件写入主线程的本地队列。回调返回后，重新监听该 fd
+     * 回调中的异常在此捕获，避免抛到工作线程中导致进程退出
+     * @param key
+     * @param events
+     */
+    void dispatch(unsigned long key, unsigned int events) {
+        std::shared_ptr<Handler> handler;
+        {
+            LOCK_GUARD lk(mutex_);
+            auto iter = handlers_.find((int)(key & 0xFFFFFFFF));
+            if (iter == handlers_.end() || iter->second->key_ != key) {
+                return;     // 已经取消注册
+            }
+            handler = iter->second;
+            handler->running_ = true;
+        }
+
+        event_num_.fetch_add(1, std::memory_order_relaxed);
+        Task task([this, handler, events] {
+            RearmGuard guard {this, handler};
+            try {
+                handler->callback_(handler->fd_, events);
+            } catch (...) {
+                error_num_.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        pool_->pushReactorTask(std::move(task), handler->slot_, handler->tag_);
+    }
+
+    /**
+     * 回调返回后，若 fd 仍处于注册状态，重新监听
+     * @param handler
+     */
+    void rearm(const std::shared_ptr<Handler>& handler) {
+        LOCK_GUARD lk(mutex_);
+        handler->running_ = false;
+        auto iter = handlers_.find(handler->fd_);
+        if (iter != handlers_.end() && iter->second == handler) {
+            arm(*handler);
+        }
+    }
+
+    /**
+     * 以 EPOLLONESHOT 方式重新监听
+     * @param handler
+     * @return
+     * @notice 调用方需持有 mutex_
+     */
+    bool arm(const Handler& handler) {
+        epoll_event event {};
+        event.events = handler.events_ | EPOLLONESHOT;
+        event.data.u64 = handler.key_;
+        return 0 == epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, handler.fd_, &event);
+    }
+
+    void notify() {
+        if (wake_fd_ >= 0) {
+            eventfd_write(wake_fd_, 1);
+        }
+    }
+
+    void closeFd() {
+        if (wake_fd_ >= 0) {
+            close(wake_fd_);
+            wake_fd_ = -1;
+        }
+        if (epoll_fd_ >= 0) {
+            close(epoll_fd_);
+            epoll_fd_ = -1;
+        }
+    }
+
+    static unsigned long makeKey(int fd, unsigned long serial) {
+        return (serial << 32) | (unsigned long)(unsigned int)fd;
+    }
+
+private:
+    static const unsigned long WAKEUP_KEY = ~0UL;                   // 唤醒用 eventfd 的标识
+
+    ThreadPool* pool_ = nullptr;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    std::atomic<bool> stop_ {false};
+    std::vector<std::thread> threads_;                              // reactor 线程
+    std::mutex mutex_;                                              // 保护 handlers_ 和各个 Handler 的状态
+    std::unordered_map<int, std::shared_ptr<Handler>> handlers_;    // 注册中的 fd
+    unsigned long serial_ = 0;
+    unsigned int slot_ = 0;
+    std::atomic<unsigned long> poll_num_ {0};
+    std::atomic<unsigned long> event_num_ {0};
+    std::atomic<unsigned long> wakeup_num_ {0};
+    std::atomic<unsigned long> error_num_ {0};
+};
+
+}
+
+#endif
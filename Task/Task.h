@@ -2,6 +2,7 @@
 #define TASK_H
 
 #include "../ThreadObject.h"
+#include "../Utils/UtilsTicker.h"
 #include <vector>
 #include <memory>
 
@@ -27,8 +28,21 @@ public:
     template<typename F>
     Task(F&& f, int priority = 0)
         : impl_(new taskDerided<F>(std::forward<F>(f)))
-        , priority_(priority){}
-    
+        , priority_(priority)
+        , enqueue_ts_(UtilsTicker::now()) {}
+
+    /**
+     * 写入优先级队列时使用，保留原任务的信息，避免再包装一层
+     * @param task
+     * @param priority
+     */
+    Task(Task&& task, int priority) noexcept:
+        impl_(std::move(task.impl_)),
+        priority_(priority),
+        segment_(task.segment_),
+        tag_(task.tag_),
+        enqueue_ts_(task.enqueue_ts_) {}
+
     void operator()(){
         impl_->call();
     }
@@ -37,14 +51,62 @@ public:
 
     Task(Task&& task) noexcept:
         impl_(std::move(task.impl_)),
-        priority_(task.priority_) {}
+        priority_(task.priority_),
+        segment_(task.segment_),
+        tag_(task.tag_),
+        enqueue_ts_(task.enqueue_ts_) {}
 
     Task &operator=(Task&& task) noexcept {
         impl_ = std::move(task.impl_);
         priority_ = task.priority_;
+        segment_ = task.segment_;
+        tag_ = task.tag_;
+        enqueue_ts_ = task.enqueue_ts_;
+        return *this;
+    }
+
+    /**
+     * 设置任务的统计信息
+     * @param segment 调度来源，参考 TASK_SEGMENT_*
+     * @param tag 用户自定义标签
+     * @return
+     */
+    Task& setTrace(int segment, int tag) {
+        segment_ = segment;
+        tag_ = tag;
+        return *this;
+    }
+
+    /**
+     * 设置任务入队时的 tick，再包装一层任务时使用，保留原任务的排队耗时
+     * @param ts
+     * @return
+     */
+    Task& setEnqueueTs(unsigned long ts) {
+        enqueue_ts_ = ts;
         return *this;
     }
 
+    int getPriority() const {
+        return priority_;
+    }
+
+    int getSegment() const {
+        return segment_;
+    }
+
+    int getTag() const {
+        return tag_;
+    }
+
+    /**
+     * 获取任务创建（入队）时的 tick
+     * @return
+     */
+    unsigned long getEnqueueTs() const {
+        return enqueue_ts_;
+    }
+
     bool operator>(const Task& task) const {
         return priority_ < task.priority_;    // 新加入的，优先级较低，放到后面
     }
@@ -57,6 +119,9 @@ public:
     private:
         std::unique_ptr<taskBased> impl_ = nullptr;
         int priority_ = 0;
+        int segment_ = TASK_SEGMENT_POOL;                       // 调度来源
+        int tag_ = DEFAULT_TASK_TAG;                            // 用户自定义标签
+        unsigned long enqueue_ts_ = 0;                          // 创建（入队）时的 tick
 };
 
 using TaskRef = Task &;
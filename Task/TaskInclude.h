@@ -4,5 +4,6 @@
 
 #include "Task.h"
 #include "TaskGroup.h"
+#include "TaskProfiler.h"
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,181 @@
+#ifndef TASKPROFILER_H
+#define TASKPROFILER_H
+
+#include "../ThreadObject.h"
+#include "../Utils/UtilsTicker.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <typeindex>
+#include <unordered_map>
+
+namespace ccy
+{
+
+/**
+ * 单个可调用类型的耗时画像快照
+ */
+struct TaskProfileInfo {
+    std::string name_;                                              // 可调用类型的名称（编译器生成）
+    unsigned long sample_num_ = 0;                                  // 统计的执行次数
+    unsigned long avg_exec_ = 0;                                    // 执行耗时的滑动平均，单位为ns
+    bool is_long_ = false;                                          // 当前是否按长时间任务处理
+    unsigned long promote_num_ = 0;                                 // 被判定为长时间任务的次数
+    unsigned long demote_num_ = 0;                                  // 恢复为普通任务的次数
+};
+
+
+/**
+ * 单个可调用类型的耗时画像，多个线程并发更新，数值允许存在少量误差
+ */
+class TaskProfile {
+public:
+    explicit TaskProfile(const char* name) : name_(name) {}
+
+    bool isLong() const {
+        return is_long_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * 记录一次执行耗时，并根据阈值切换是否按长时间任务处理
+     * 耗时的滑动平均超过 promoteTicks 时升级，低于 demoteTicks 时降级，两个阈值之间保持不变
+     * @param ticks
+     * @param promoteTicks
+     * @param demoteTicks
+     */
+    void record(unsigned long ticks, unsigned long promoteTicks, unsigned long demoteTicks) {
+        unsigned long num = sample_num_.fetch_add(1, std::memory_order_relaxed) + 1;
+        unsigned long avg = avg_ticks_.load(std::memory_order_relaxed);
+        avg = (1 == num) ? ticks : avg - avg / 8 + ticks / 8;      // 并发更新时可能丢失个别样本，不影响趋势
+        avg_ticks_.store(avg, std::memory_order_relaxed);
+        if (num < AUTO_ROUTE_MIN_SAMPLE) {
+            return;
+        }
+
+        bool isLong = is_long_.load(std::memory_order_relaxed);
+        if (!isLong && avg > promoteTicks) {
+            if (!is_long_.exchange(true, std::memory_order_relaxed)) {
+                promote_num_.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else if (isLong && avg < demoteTicks) {
+            if (is_long_.exchange(false, std::memory_order_relaxed)) {
+                demote_num_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void snapshot(TaskProfileInfo& info) const {
+        info.name_ = name_;
+        info.sample_num_ = sample_num_.load(std::memory_order_relaxed);
+        info.avg_exec_ = UtilsTicker::toNs(avg_ticks_.load(std::memory_order_relaxed));
+        info.is_long_ = is_long_.load(std::memory_order_relaxed);
+        info.promote_num_ = promote_num_.load(std::memory_order_relaxed);
+        info.demote_num_ = demote_num_.load(std::memory_order_relaxed);
+    }
+
+    NO_ALLOWED_COPY(TaskProfile)
+
+private:
+    const char* name_;
+    std::atomic<unsigned long> sample_num_ {0};
+    std::atomic<unsigned long> avg_ticks_ {0};                      // 执行耗时的滑动平均，单位为 tick
+    std::atomic<bool> is_long_ {false};
+    std::atomic<unsigned long> promote_num_ {0};
+    std::atomic<unsigned long> demote_num_ {0};
+};
+
+
+/**
+ * 按可调用类型记录执行耗时，用于自动识别长时间任务
+ * 每个 lambda 都是独立的类型，因此相当于按提交位置区分；通过 std::function 提交的任务共用一个画像
+ */
+class TaskProfiler {
+public:
+    TaskProfiler() : serial_(nextSerial()) {}
+
+    /**
+     * 设置升级/降级的阈值
+     * @param promoteUs
+     * @param demoteUs
+     * @notice 需在提交任务之前设置
+     */
+    void setThreshold(long promoteUs, long demoteUs) {
+        double ticksPerUs = 1000.0 / UtilsTicker::nsPerTick();
+        promote_ticks_ = (unsigned long)((double)promoteUs * ticksPerUs);
+        demote_ticks_ = (unsigned long)((double)demoteUs * ticksPerUs);
+    }
+
+    /**
+     * 获取类型对应的画像，不存在时创建
+     * 每个线程缓存最近一次查询的结果，重复提交同一类型时无需加锁
+     * @tparam FunctionType
+     * @return
+     */
+    template<typename FunctionType>
+    TaskProfile* get() {
+        static thread_local unsigned long cacheSerial = 0;
+        static thread_local TaskProfile* cacheProfile = nullptr;
+        if (likely(cacheSerial == serial_)) {
+            return cacheProfile;
+        }
+
+        const std::type_info& type = typeid(FunctionType);
+        LOCK_GUARD lk(mutex_);
+        auto& profile = profiles_[std::type_index(type)];
+        if (nullptr == profile) {
+            profile.reset(new TaskProfile(type.name()));
+        }
+        cacheSerial = serial_;
+        cacheProfile = profile.get();
+        return cacheProfile;
+    }
+
+    /**
+     * 记录一次执行耗时
+     * @param profile
+     * @param ticks
+     */
+    void record(TaskProfile* profile, unsigned long ticks) const {
+        profile->record(ticks, promote_ticks_, demote_ticks_);
+    }
+
+    /**
+     * 获取所有画像的快照
+     * @param infos
+     */
+    void snapshot(std::vector<TaskProfileInfo>& infos) {
+        LOCK_GUARD lk(mutex_);
+        infos.clear();
+        infos.reserve(profiles_.size());
+        for (const auto& cur : profiles_) {
+            TaskProfileInfo info;
+            cur.second->snapshot(info);
+            infos.emplace_back(std::move(info));
+        }
+    }
+
+    NO_ALLOWED_COPY(TaskProfiler)
+
+protected:
+    /**
+     * 每个实例使用唯一的序号，避免线程缓存指向已经释放的实例
+     */
+    static unsigned long nextSerial() {
+        static std::atomic<unsigned long> serial {0};
+        return serial.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+private:
+    const unsigned long serial_;
+    unsigned long promote_ticks_ = 0;
+    unsigned long demote_ticks_ = 0;
+    std::mutex mutex_;
+    std::unordered_map<std::type_index, std::unique_ptr<TaskProfile>> profiles_;      // 画像只增不减，指针始终有效
+};
+
+}
+
+#endif
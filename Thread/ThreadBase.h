@@ -6,8 +6,12 @@
 #include "../Queue/QueueInclude.h"
 #include "../Task/TaskInclude.h"
 #include "../ThreadPoolConfig.h"
+#include "ThreadStats.h"
+#include "ThreadTrace.h"
+#include "../Memory/ScratchArena.h"
 #include <thread>
-#include <iostream>
+#include <atomic>
+#include <memory>
 
 namespace ccy
 {
@@ -18,9 +22,10 @@ protected:
         done_ = true;
         is_init_ = false;
         is_running_ = false;
-        total_task_num_ = 0;
         pool_task_queue_ = nullptr;
         pool_priority_task_queue_ = nullptr;
+        pool_fair_task_queue_ = nullptr;
+        pool_deadline_task_queue_ = nullptr;
         config_ = nullptr;
     }
 
@@ -40,6 +45,34 @@ protected:
         return status;
     }
 
+    /**
+     * 从带截止时间的队列中，获取截止时间最早的任务
+     * @param task
+     * @return
+     */
+    bool popDeadlineTask(TaskRef task) {
+        bool result = pool_deadline_task_queue_->tryPop(task);
+        if (result) {
+            stats_.recordPoolPop(1);
+        }
+        return result;
+    }
+
+    /**
+     * 从带截止时间的队列中，获取一个任务
+     * @param tasks
+     * @return
+     * @notice 每次仅获取一个，避免批量执行时，后续任务的截止时间被前面的任务拖过
+     */
+    bool popDeadlineTask(TaskArrRef tasks) {
+        Task task;
+        bool result = popDeadlineTask(task);
+        if (result) {
+            tasks.emplace_back(std::move(task));
+        }
+        return result;
+    }
+
     /**
      * 从线程池的队列中，获取任务
      * @param task
@@ -51,6 +84,12 @@ protected:
             // 若辅助线程没有获取到的话，再尝试从任务队列中获取一次
             result = pool_priority_task_queue_->tryPop(task);
         }
+        if (!result && pool_fair_task_queue_) {
+            result = pool_fair_task_queue_->tryPop(task);    // 最后尝试带类别的任务
+        }
+        if (result) {
+            stats_.recordPoolPop(1);
+        }
         return result;
     }
 
@@ -64,6 +103,16 @@ protected:
         if (!result && THREAD_TYPE_SECONDARY == type_) {
             result = pool_priority_task_queue_->tryPop(tasks, 1);    // 从优先队列里，pop出来一个
         }
+        if (!result && pool_fair_task_queue_) {
+            Task task;
+            result = pool_fair_task_queue_->tryPop(task);    // 带类别的任务每次只取一个，保证公平调度的粒度
+            if (result) {
+                tasks.emplace_back(std::move(task));
+            }
+        }
+        if (result) {
+            stats_.recordPoolPop(tasks.size());
+        }
         return result;
     }
 
@@ -72,10 +121,15 @@ protected:
      * @param task
      */
     void runTask(Task& task){
-        is_running_ = true;
+        is_running_.store(true, std::memory_order_relaxed);
+        auto start = UtilsTicker::now();
+        recordTrace(TraceEventType::TASK_START, start, traceArg(task));
         task();
-        total_task_num_++;
-        is_running_ = false;
+        auto end = UtilsTicker::now();
+        recordTrace(TraceEventType::TASK_END, end);
+        stats_.recordTask(1, end - start, recordLatency(task, start, end));
+        resetArena();
+        is_running_.store(false, std::memory_order_relaxed);
     }
 
     /**
@@ -83,14 +137,111 @@ protected:
      * @param tasks
      */
     void runTasks(TaskArr& tasks) {
-        is_running_ = true;
+        is_running_.store(true, std::memory_order_relaxed);
+        auto start = UtilsTicker::now();
+        auto begin = start;
+        unsigned long waitTicks = 0;
         for (auto& task : tasks) {
+            recordTrace(TraceEventType::TASK_START, begin, traceArg(task));
             task();
+            auto end = UtilsTicker::now();
+            recordTrace(TraceEventType::TASK_END, end);
+            waitTicks += recordLatency(task, begin, end);
+            begin = end;
         }
-        total_task_num_ += tasks.size();
-        is_running_ = false;
+        stats_.recordTask(tasks.size(), begin - start, waitTicks);
+        resetArena();
+        is_running_.store(false, std::memory_order_relaxed);
     }
 
+    /**
+     * 获取本线程的临时内存，首次调用时创建
+     * @return
+     * @notice 只能在本线程中调用
+     */
+    ScratchArena* getArena() {
+        if (unlikely(!arena_)) {
+            arena_.reset(new ScratchArena());
+        }
+        return arena_.get();
+    }
+
+    /**
+     * 任务（或一批任务）结束后，重置临时内存。未使用时仅有一次判空
+     */
+    void resetArena() {
+        if (unlikely(arena_)) {
+            arena_->reset();
+        }
+    }
+
+    /**
+     * 记录任务的排队耗时和执行耗时
+     * @param task
+     * @param start 开始执行的tick
+     * @param end 执行结束的tick
+     * @return 排队耗时
+     */
+    unsigned long recordLatency(const Task& task, unsigned long start, unsigned long end) {
+        // 不同核心之间 tsc 可能有极小的偏差，防止出现负数
+        unsigned long waitTicks = start > task.getEnqueueTs() ? start - task.getEnqueueTs() : 0;
+        if (unlikely(latency_)) {
+            latency_->record(task.getSegment(), task.getTag(), waitTicks, end - start);
+        }
+        return waitTicks;
+    }
+
+    /**
+     * 根据配置信息，开启延迟直方图
+     */
+    void buildLatency() {
+        if (config_->latency_histogram_enable_ && !latency_) {
+            latency_.reset(new ThreadLatency());
+        }
+    }
+
+    /**
+     * 根据配置信息，开启调度事件记录
+     * @param tid 导出时使用的线程id
+     */
+    void buildTrace(int tid) {
+        if (config_->trace_enable_ && !trace_) {
+            trace_.reset(new ThreadTrace(tid, (unsigned int)config_->trace_buffer_size_));
+        }
+    }
+
+    /**
+     * 记录调度事件，未开启时仅有一次判空
+     * @param type
+     * @param ts
+     * @param arg
+     */
+    void recordTrace(TraceEventType type, unsigned long ts, unsigned int arg = 0) {
+        if (unlikely(trace_)) {
+            trace_->record(type, ts, arg);
+        }
+    }
+
+    /**
+     * 任务开始事件的参数：低8位为 segment，其余为 tag
+     * @param task
+     * @return
+     */
+    static unsigned int traceArg(const Task& task) {
+        return ((unsigned int)task.getSegment() & 0xFF) | ((unsigned int)task.getTag() << 8);
+    }
+
+    /**
+     * 获取当前线程运行信息的快照，可以在任意线程中调用
+     * @param info
+     */
+    void snapshotStats(ThreadStatsInfo& info) const {
+        info.type_ = type_;
+        info.is_running_ = is_running_.load(std::memory_order_relaxed);
+        stats_.snapshot(info);
+    }
+
+
     /**
      * 清空所有任务内容
      */
@@ -101,7 +252,6 @@ protected:
         }
         is_init_ = false;
         is_running_ = false;
-        total_task_num_ = 0;
     }
 
     /**
@@ -123,6 +273,7 @@ protected:
     Status loopProcess(){
         Status status;
         ASSERT_NOT_NULL(config_)
+        current() = this;
         if(config_->batch_task_enable_){
             while (done_){
                 processTasks();                         // 执行批量任务
@@ -133,15 +284,27 @@ protected:
             }
         }
 
+        current() = nullptr;
         return status;
     }
 
     /**
-    * 设置线程优先级
-    */
-    void setSchedParam() {
-        int priority = THREAD_SCHED_OTHER;
-        int policy = THREAD_MIN_PRIORITY;
+     * 当前线程所属的线程对象，非线程池中的线程为空
+     * @return
+     */
+    static ThreadBase*& current() {
+        static thread_local ThreadBase* cur = nullptr;
+        return cur;
+    }
+
+    /**
+     * 根据线程类型，设置配置中对应的调度策略和优先级
+     * @return
+     * @notice 设置失败时，线程保持原有的调度策略继续运行
+     */
+    Status setSchedParam() {
+        int policy = THREAD_SCHED_OTHER;
+        int priority = THREAD_MIN_PRIORITY;
         if (type_ == THREAD_TYPE_PRIMARY) {
             priority = config_->primary_thread_priority_;
             policy = config_->primary_thread_policy_;
@@ -149,15 +312,26 @@ protected:
             priority = config_->secondary_thread_priority_;
             policy = config_->secondary_thread_policy_;
         }
+        return setSchedParam(policy, priority);
+    }
 
-        auto handle = thread_.native_handle();
-        sched_param param = { calcPriority(priority) };
-        int ret = pthread_setschedparam(handle, calcPolicy(policy), &param);
-        if (0 != ret) {
-            std::cout << "warning : set thread sched param failed, system error code is " << ret;
-        }
+    /**
+     * 设置线程的调度策略和优先级
+     * @param policy
+     * @param priority
+     * @return 失败时返回系统错误码，如无 CAP_SYS_NICE 权限时设置实时策略，返回 EPERM
+     */
+    Status setSchedParam(int policy, int priority) {
+        Status status;
+        policy = calcPolicy(policy);
+        // 非实时策略的优先级只能为0
+        sched_param param = { THREAD_SCHED_OTHER == policy ? 0 : calcPriority(priority) };
+        int ret = pthread_setschedparam(thread_.native_handle(), policy, &param);
+        RETURN_ERROR_STATUS_BY_CONDITION(0 != ret, "set thread sched param failed, system error code is "
+                                                   + std::to_string(ret))
+        return status;
     }
-    
+
     /**
      * 设定线程优先级信息
      * 超过[min,max]范围，统一设置为min值
@@ -183,16 +357,24 @@ protected:
                ? policy : THREAD_SCHED_OTHER;
     }
 protected:
-    bool done_;                                                        // 线程状态标记
+    std::atomic<bool> done_;                                           // 线程状态标记
     bool is_init_;                                                     // 标记初始化状态
-    bool is_running_;                                                  // 是否正在执行
+    std::atomic<bool> is_running_;                                     // 是否正在执行
     int type_ = 0;                                                     // 用于区分线程类型（主线程、辅助线程）
-    unsigned long total_task_num_ = 0;                                 // 处理的任务的数量
+    ThreadStats stats_;                                                // 运行统计信息，仅本线程写入
+    std::unique_ptr<ThreadLatency> latency_;                           // 任务延迟直方图，未开启时为空
+    std::unique_ptr<ThreadTrace> trace_;                               // 调度事件记录，未开启时为空
+    std::unique_ptr<ScratchArena> arena_;                              // 任务可使用的临时内存，首次使用时创建，仅本线程访问
 
     AtomicQueue<Task>* pool_task_queue_;                             // 用于存放线程池中的普通任务
     AtomicPriorityQueue<Task>* pool_priority_task_queue_;            // 用于存放线程池中的包含优先级任务的队列，仅辅助线程可以执行
+    FairTaskQueue* pool_fair_task_queue_;                            // 用于存放线程池中带类别的任务，按权重公平调度
+    DeadlineTaskQueue* pool_deadline_task_queue_;                    // 用于存放线程池中带截止时间的任务，所有线程优先执行
     ThreadPoolConfigPtr config_ = nullptr;                            // 配置参数信息
     std::thread thread_;                                               // 线程类
+    int blocking_depth_ = 0;                                           // 嵌套的阻塞区间层数，仅本线程读写
+
+    friend class ThreadPool;
 
 
 };
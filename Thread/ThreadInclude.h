@@ -1,7 +1,10 @@
 #ifndef THREADINCLUDE_H
 #define THREADINCLUDE_H
 
+#include "ThreadStats.h"
+#include "ThreadTrace.h"
 #include "ThreadPrimary.h"
 #include "ThreadSecondary.h"
+#include "ThreadRealtime.h"
 
 #endif 
\ No newline at end of file
@@ -5,9 +5,12 @@
 */
 
 #include "ThreadBase.h"
+#include "../Utils/UtilsBitmap.h"
 
 #include <vector>
 #include <mutex>
+#include <chrono>
+#include <functional>
 #include <condition_variable>
 
 namespace ccy
@@ -24,11 +27,16 @@ protected:
     Status init() override{
         Status status;
         ASSERT_INIT(false)
-        ASSERT_NOT_NULL(config_)
+        ASSERT_NOT_NULL(config_, pool_primary_size_)
         is_init_ = true;
-        buildStealTargets();
+        done_ = true;                       // 被回收后重新启动时，需要恢复运行标记
+        is_idle_ = false;
+        buildIdleBudget();
+        buildStealTargets(pool_primary_size_->load(std::memory_order_acquire));
+        buildLatency();
+        buildTrace(index_);
         thread_ = std::move(std::thread(&ThreadPrimary::run, this));
-        setSchedParam();
+        setSchedParam();                    // 失败时保持默认的调度策略
         return status;
     }
 
@@ -36,20 +44,32 @@ protected:
      * 注册线程池相关内容
      * @param index
      * @param poolTaskQueue
+     * @param poolFairTaskQueue 带类别的任务队列
+     * @param poolDeadlineTaskQueue 带截止时间的任务队列
      * @param poolThreads
+     * @param poolPrimarySize 当前生效的主线程数量
+     * @param poolIdleMask 空闲主线程的位图
      * @param config
      */
     Status setThreadPoolInfo(int index,
                               AtomicQueue<Task>* poolTaskQueue,
+                              FairTaskQueue* poolFairTaskQueue,
+                              DeadlineTaskQueue* poolDeadlineTaskQueue,
                               std::vector<ThreadPrimary *>* poolThreads,
+                              std::atomic<int>* poolPrimarySize,
+                              UtilsAtomicBitmap* poolIdleMask,
                               ThreadPoolConfigPtr config) {
         Status status;
         ASSERT_INIT(false)    // 初始化之前，设置参数
-        ASSERT_NOT_NULL(poolTaskQueue, poolThreads, config)
+        ASSERT_NOT_NULL(poolTaskQueue, poolFairTaskQueue, poolDeadlineTaskQueue, poolThreads, poolPrimarySize, poolIdleMask, config)
 
         this->index_ = index;
         this->pool_task_queue_ = poolTaskQueue;
+        this->pool_fair_task_queue_ = poolFairTaskQueue;
+        this->pool_deadline_task_queue_ = poolDeadlineTaskQueue;
         this->pool_threads_ = poolThreads;
+        this->pool_primary_size_ = poolPrimarySize;
+        this->pool_idle_mask_ = poolIdleMask;
         this->config_ = config;
         return status;
     }
@@ -78,32 +98,204 @@ protected:
     
     void processTask() override{
         Task task;
-        if(popTask(task) || popPoolTask(task) || stealTask(task)){
+        // 带截止时间的任务，先于本地队列执行
+        if(popDeadlineTask(task) || popTask(task) || popPoolTask(task) || stealTask(task)){
+            finishIdle();
+            markBusy();
+            chainWakeup();
             runTask(task);
+            pollWaiting();
+        } else if (!pollWaiting()) {
+            markIdle();
+            fatWait();
         }
     }
     
     void processTasks() override {
         TaskArr tasks;
-        if (popTask(tasks) || popPoolTask(tasks) || stealTask(tasks)) {
+        if (popDeadlineTask(tasks) || popTask(tasks) || popPoolTask(tasks) || stealTask(tasks)) {
             // 尝试从主线程中获取/盗取批量task，如果成功，则依次执行
+            finishIdle();
+            markBusy();
+            chainWakeup();
             runTasks(tasks);
-        } else {
+            pollWaiting();
+        } else if (!pollWaiting()) {
+            markIdle();
             fatWait();
         }
     }
+
+    /**
+     * 在位图中标记本线程空闲
+     * 分发方抢占时会清除该bit。若任务被其他线程窃取，本线程仍处于空闲，故每次都需要检查
+     */
+    void markIdle() {
+        is_idle_ = true;
+        if (!pool_idle_mask_->test(index_)) {
+            pool_idle_mask_->set(index_);
+        }
+    }
+
     /**
-     * 如果总是进入无task的状态，则开始休眠
+     * 在位图中清除本线程空闲的标记，仅在状态变化时写入
+     */
+    void markBusy() {
+        if (unlikely(is_idle_)) {
+            is_idle_ = false;
+            pool_idle_mask_->clear(index_);
+        }
+    }
+    /**
+     * 没有获取到任务时调用：先按指数退避空转，满足空闲策略的条件后休眠
      * 休眠一定时间后，然后恢复执行状态
      */
     void fatWait() {
+        if (0 == cur_empty_epoch_) {
+            idle_start_ = UtilsTicker::now();
+        }
         cur_empty_epoch_++;
-        std::this_thread::yield();
-        if (cur_empty_epoch_ >= config_->primary_thread_busy_epoch_) {
+        backoff();
+
+        long interval = 0;
+        switch (config_->idle_strategy_) {
+            case IDLE_STRATEGY_BUSY_POLL:
+                return;
+            case IDLE_STRATEGY_DEEP_SLEEP:
+                if (cur_empty_epoch_ < config_->primary_thread_busy_epoch_) {
+                    return;
+                }
+                // 连续休眠超时，说明负载很低，逐步延长下一次休眠的时间
+                interval = sleep_interval_;
+                sleep_interval_ = std::min(sleep_interval_ * 2, std::max(IDLE_DEEP_SLEEP_MAX_INTERVAL, interval));
+                break;
+            default:
+                if (UtilsTicker::now() - idle_start_ < spin_budget_) {
+                    return;
+                }
+                interval = config_->primary_thread_empty_interval_;
+                break;
+        }
+
+        auto start = UtilsTicker::now();
+        std::chrono::microseconds timeout = std::chrono::milliseconds(interval);
+        if (!waiting_.empty()) {
+            // 有等待中的任务时，最多休眠到下一次检查
+            long remain = (long)((double)(waiting_poll_ts_ > start ? waiting_poll_ts_ - start : 0) * UtilsTicker::nsPerTick() / 1000.0);
+            timeout = std::min(timeout, std::chrono::microseconds(remain + 1));
+        }
+        recordTrace(TraceEventType::PARK, start);
+        {
             UNIQUE_LOCK lk(mutex_);
-            cv_.wait_for(lk, std::chrono::milliseconds(config_->primary_thread_empty_interval_));
-            cur_empty_epoch_ = 0;
+            parked_.store(true, std::memory_order_relaxed);
+            // 与 afterPush() / ThreadPool::wakeupIdlePrimary() 配合：要么提交方看到 parked_ 后唤醒本线程，要么这里看到新写入的任务
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!hasPendingTask()) {
+                cv_.wait_for(lk, timeout, [this] {
+                    return !parked_.load(std::memory_order_relaxed) || !done_;
+                });
+            }
+            chain_wakeup_ = !parked_.load(std::memory_order_relaxed);      // 被提交方唤醒，而不是超时
+            parked_.store(false, std::memory_order_relaxed);
+        }
+        auto end = UtilsTicker::now();
+        recordTrace(TraceEventType::UNPARK, end);
+        stats_.recordPark(end - start);
+    }
+
+    /**
+     * 空转时的指数退避：前几轮 pause 的次数逐轮翻倍，不陷入内核；之后改为 yield，让出cpu
+     */
+    void backoff() {
+        if (cur_empty_epoch_ <= pause_max_shift_) {
+            for (int i = (1 << cur_empty_epoch_); i > 0; i--) {
+                UtilsTicker::relax();
+            }
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * 获取到任务时调用，结束本次空闲。自适应策略下，根据本次空闲的时长更新自旋预算
+     */
+    void finishIdle() {
+        if (likely(0 == cur_empty_epoch_)) {
+            return;
+        }
+        if (IDLE_STRATEGY_ADAPTIVE == config_->idle_strategy_) {
+            // 任务到达间隔的滑动平均（权重 1/8）
+            unsigned long gap = UtilsTicker::now() - idle_start_;
+            avg_idle_gap_ = avg_idle_gap_ - avg_idle_gap_ / 8 + gap / 8;
+            /**
+             * 间隔较短时，自旋覆盖大部分间隔，即可在下一个任务到达前避免休眠和唤醒
+             * 间隔超出自旋上限时，自旋大概率等不到任务，只保留最短的自旋，尽快休眠
+             */
+            unsigned long budget = avg_idle_gap_ * 2;
+            spin_budget_ = budget > spin_max_ticks_ ? spin_min_ticks_ : std::max(budget, spin_min_ticks_);
         }
+        cur_empty_epoch_ = 0;
+        sleep_interval_ = config_->primary_thread_empty_interval_;
+    }
+
+    /**
+     * 将自旋时间的上下限换算成 tick，避免每次空转时重复换算
+     */
+    void buildIdleBudget() {
+        double nsPerTick = UtilsTicker::nsPerTick();
+        spin_min_ticks_ = (unsigned long)((double)IDLE_SPIN_MIN_TIME * 1000.0 / nsPerTick);
+        spin_max_ticks_ = (unsigned long)((double)IDLE_SPIN_MAX_TIME * 1000.0 / nsPerTick);
+        spin_budget_ = spin_min_ticks_;
+        // 单核时，pause 只会推迟提交方和其他线程的执行，直接 yield
+        pause_max_shift_ = std::thread::hardware_concurrency() > 1 ? IDLE_PAUSE_MAX_SHIFT : 0;
+        avg_idle_gap_ = 0;
+        cur_empty_epoch_ = 0;
+        sleep_interval_ = config_->primary_thread_empty_interval_;
+        waiting_min_ticks_ = (unsigned long)((double)FIBER_AWAIT_MIN_INTERVAL * 1000.0 / nsPerTick);
+        waiting_max_ticks_ = (unsigned long)((double)FIBER_AWAIT_MAX_INTERVAL * 1000.0 / nsPerTick);
+    }
+
+    /**
+     * 暂存需等待条件满足后才能执行的任务，如 Fiber::await() 中挂起的协程。仅由本线程调用
+     * @param ready 条件是否满足，在本线程中检查
+     * @param task 条件满足后写入本地队列
+     */
+    void pushWaiting(std::function<bool()>&& ready, Task&& task) {
+        if (waiting_.empty()) {
+            waiting_interval_ = waiting_min_ticks_;
+            waiting_poll_ts_ = UtilsTicker::now() + waiting_interval_;
+        }
+        waiting_.emplace_back(std::move(ready), std::move(task));
+    }
+
+    /**
+     * 到达检查时间后，将条件满足的任务写入本地队列
+     * 均未满足时，检查间隔逐次翻倍，直到 FIBER_AWAIT_MAX_INTERVAL，使本线程空闲时仍可以休眠，而不是持续轮询
+     * @return 是否有任务写入本地队列
+     */
+    bool pollWaiting() {
+        if (likely(waiting_.empty())) {
+            return false;
+        }
+        auto now = UtilsTicker::now();
+        if (now < waiting_poll_ts_) {
+            return false;
+        }
+
+        bool resumed = false;
+        for (size_t i = 0; i < waiting_.size(); ) {
+            if (waiting_[i].first()) {
+                pushTask(std::move(waiting_[i].second));
+                std::swap(waiting_[i], waiting_.back());
+                waiting_.pop_back();
+                resumed = true;
+            } else {
+                i++;
+            }
+        }
+        waiting_interval_ = resumed ? waiting_min_ticks_ : std::min(waiting_interval_ * 2, waiting_max_ticks_);
+        waiting_poll_ts_ = now + waiting_interval_;
+        return resumed;
     }
 
 
@@ -117,7 +309,166 @@ protected:
                  || secondary_queue_.tryPush(std::move(task)))) {
             std::this_thread::yield();
         }
+        afterPush();
+    }
+
+    /**
+     * 批量写入任务，最多唤醒一次
+     * @param tasks
+     */
+    void pushTasks(TaskArr& tasks) {
+        while (!(primary_queue_.tryPush(tasks) || secondary_queue_.tryPush(tasks))) {
+            std::this_thread::yield();
+        }
+        afterPush();
+    }
+
+    /**
+     * 写入任务之后的处理：仅在本线程休眠时唤醒
+     */
+    void afterPush() {
+        /**
+         * 与 fatWait() 配合：要么这里看到 parked_ 后唤醒，要么休眠方看到本次写入
+         * 提交方可能读取到了缩容之前的主线程数量。与 retire() 配合：
+         * 要么回收方的转移能看到本次写入，要么本次能看到回收标记，由提交方自己转移
+         */
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked_.load(std::memory_order_relaxed)) {
+            wakeup();
+        }
+        if (unlikely(retired_.load(std::memory_order_relaxed))) {
+            drainTasks();
+        }
+    }
+
+    /**
+     * 唤醒休眠中的本线程
+     * @return 本线程是否处于休眠
+     */
+    bool wakeup() {
+        {
+            LOCK_GUARD lk(mutex_);
+            if (!parked_.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            parked_.store(false, std::memory_order_relaxed);
+        }
         cv_.notify_one();
+        wakeup_num_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * 被唤醒后，若本地仍有积压的任务，继续唤醒一个会从本线程窃取任务的休眠线程
+     * 被唤醒的线程同样如此，使唤醒沿着窃取关系逐个传递，而不是由提交方一次唤醒多个
+     */
+    void chainWakeup() {
+        if (likely(!chain_wakeup_)) {
+            return;
+        }
+        chain_wakeup_ = false;
+        int primarySize = pool_primary_size_->load(std::memory_order_acquire);
+        if (!hasLocalTask() || primarySize <= 1) {
+            return;
+        }
+        int range = config_->calcStealRange(primarySize);
+        for (int i = 1; i <= range; i++) {
+            auto* peer = (*pool_threads_)[(index_ - i + primarySize) % primarySize];
+            if (peer->parked_.load(std::memory_order_relaxed) && peer->wakeup()) {
+                break;
+            }
+        }
+    }
+
+    /**
+     * 本地队列中是否有任务，结果仅供参考
+     * @return
+     */
+    bool hasLocalTask() const {
+        return primary_queue_.getApproxSize() > 0 || secondary_queue_.getApproxSize() > 0;
+    }
+
+    /**
+     * 本地队列，以及主线程会读取的pool队列中是否有任务，结果仅供参考
+     * @return
+     */
+    bool hasPendingTask() const {
+        return hasLocalTask()
+               || pool_task_queue_->getApproxSize() > 0
+               || pool_deadline_task_queue_->getApproxSize() > 0
+               || pool_fair_task_queue_->getRunnableSize() > 0;        // 达到并发上限的任务无法取出，不影响休眠
+    }
+
+    /**
+     * 停止执行。先唤醒休眠中的线程，避免等到休眠超时才能退出
+     * @return
+     */
+    Status destroy() override {
+        Status status;
+        ASSERT_INIT(true)
+        {
+            LOCK_GUARD lk(mutex_);
+            done_ = false;
+        }
+        cv_.notify_one();
+        status = ThreadBase::destroy();
+        return status;
+    }
+
+    /**
+     * 回收本线程：停止执行，并将本地队列中剩余的任务转移到pool的队列中
+     * 对象本身不会被释放，之后可以再次 init()
+     * @return
+     * @notice 调用前，需先将本线程移出生效范围，避免继续分发任务
+     */
+    Status retire() {
+        Status status;
+        retired_.store(true, std::memory_order_seq_cst);
+        status = destroy();
+        pool_idle_mask_->clear(index_);
+        // 线程已经退出，等待中的任务交给其他主线程，恢复执行后重新等待
+        for (auto& waiting : waiting_) {
+            pool_task_queue_->push(std::move(waiting.second));
+        }
+        if (!waiting_.empty()) {
+            waiting_.clear();
+            wakeupPeer();
+        }
+        drainTasks();
+        return status;
+    }
+
+    /**
+     * 将本地队列中剩余的任务，全部转移到pool的队列中
+     */
+    void drainTasks() {
+        Task task;
+        bool drained = false;
+        while (primary_queue_.getApproxSize() > 0 || secondary_queue_.getApproxSize() > 0) {
+            if (secondary_queue_.trySteal(task) || primary_queue_.trySteal(task)) {
+                pool_task_queue_->push(std::move(task));
+                drained = true;
+            } else {
+                std::this_thread::yield();      // 其他线程正在窃取，稍后重试
+            }
+        }
+        if (drained) {
+            wakeupPeer();
+        }
+    }
+
+    /**
+     * 向pool的队列写入任务后，唤醒一个休眠中的其他主线程
+     */
+    void wakeupPeer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int primarySize = pool_primary_size_->load(std::memory_order_acquire);
+        for (int i = 0; i < primarySize; i++) {
+            auto* peer = (*pool_threads_)[i];
+            if (peer != this && peer->parked_.load(std::memory_order_relaxed) && peer->wakeup()) {
+                break;
+            }
+        }
     }
 
     /**
@@ -126,7 +477,11 @@ protected:
      * @return
      */
     bool popTask(TaskRef task) {
-        return primary_queue_.tryPop(task) || secondary_queue_.tryPop(task);
+        bool result = primary_queue_.tryPop(task) || secondary_queue_.tryPop(task);
+        if (result) {
+            stats_.recordLocalPop(1);
+        }
+        return result;
     }
 
     /**
@@ -141,6 +496,9 @@ protected:
             // 如果凑齐了，就不需要了。没凑齐的话，就继续
             result |= (secondary_queue_.tryPop(tasks, leftSize));
         }
+        if (result) {
+            stats_.recordLocalPop(tasks.size());
+        }
         return result;
     }
     
@@ -150,13 +508,7 @@ protected:
      * @return
      */
     bool stealTask(TaskRef task) {
-        if (unlikely(pool_threads_->size() < config_->default_thread_size_)) {
-            /**
-             * 线程池还未初始化完毕的时候，无法进行steal。
-             * 确保程序安全运行。
-             */
-            return false;
-        }
+        refreshStealTargets();
 
         /**
          * 窃取的时候，仅从相邻的primary线程中窃取
@@ -171,10 +523,15 @@ protected:
             if (likely((*pool_threads_)[target])
                 && (((*pool_threads_)[target])->secondary_queue_.trySteal(task))
                     || ((*pool_threads_)[target])->primary_queue_.trySteal(task)) {
+                stats_.recordSteal(true);
+                recordTrace(TraceEventType::STEAL, UtilsTicker::now(), (unsigned int)target);
                 return true;
             }
         }
 
+        if (!steal_targets_.empty()) {
+            stats_.recordSteal(false);
+        }
         return false;
     }
 
@@ -184,9 +541,7 @@ protected:
      * @return
      */
     bool stealTask(TaskArrRef tasks) {
-        if (unlikely(pool_threads_->size() != config_->default_thread_size_)) {
-            return false;
-        }
+        refreshStealTargets();
 
         for (auto& target : steal_targets_) {
             if (likely((*pool_threads_)[target])) {
@@ -202,40 +557,79 @@ protected:
                      * 如果从某一个邻居中，获取了 y(<=x) 个task，则也终止steal的流程
                      * 且如果如果有一次批量steal成功，就认定成功
                      */
+                    stats_.recordSteal(true);
+                    recordTrace(TraceEventType::STEAL, UtilsTicker::now(), (unsigned int)target);
                     return true;
                 }
             }
         }
 
+        if (!steal_targets_.empty()) {
+            stats_.recordSteal(false);
+        }
         return false;
     }
 
     /**
      * 构造 steal 范围的 target，避免每次盗取的时候，重复计算
+     * @param primarySize 当前的主线程数量
      * @return
      */
-    void buildStealTargets() {
+    void buildStealTargets(int primarySize) {
+        steal_size_ = primarySize;
         steal_targets_.clear();
-        for(int i = 0; i < config_->calcStealRange(); i++){
-            auto target = (index_ + i + 1) % config_->default_thread_size_;
+        for(int i = 0; i < config_->calcStealRange(primarySize); i++){
+            auto target = (index_ + i + 1) % primarySize;
             steal_targets_.emplace_back(target);
         }
         steal_targets_.shrink_to_fit();
     }
 
+    /**
+     * 主线程数量发生变化后，在本线程内重新构造 steal 范围
+     * 窃取范围只和 index 和主线程数量有关，故只需比较数量
+     */
+    void refreshStealTargets() {
+        int primarySize = pool_primary_size_->load(std::memory_order_acquire);
+        if (unlikely(primarySize != steal_size_)) {
+            buildStealTargets(primarySize);
+        }
+    }
+
 
 private:
     int index_;                                                     // 线程index
     int cur_empty_epoch_ = 0;                                       // 当前空转的轮数信息
+    unsigned long idle_start_ = 0;                                  // 本次空闲开始的时间，单位为tick
+    unsigned long avg_idle_gap_ = 0;                                // 空闲时长（即任务到达间隔）的滑动平均，单位为tick
+    unsigned long spin_budget_ = 0;                                 // 自适应策略下，休眠前的自旋时长，单位为tick
+    unsigned long spin_min_ticks_ = 0;                              // 自旋时长的下限，单位为tick
+    unsigned long spin_max_ticks_ = 0;                              // 自旋时长的上限，单位为tick
+    long sleep_interval_ = 0;                                       // 深度休眠策略下，下一次休眠的时间，单位为ms
+    int pause_max_shift_ = 0;                                       // 空转时使用 pause 的轮数，单核时为0
+    std::vector<std::pair<std::function<bool()>, Task>> waiting_;   // 等待条件满足的任务，仅本线程读写
+    unsigned long waiting_poll_ts_ = 0;                             // 下一次检查 waiting_ 的时间，单位为tick
+    unsigned long waiting_interval_ = 0;                            // 当前的检查间隔，单位为tick
+    unsigned long waiting_min_ticks_ = 0;                           // 检查间隔的下限，单位为tick
+    unsigned long waiting_max_ticks_ = 0;                           // 检查间隔的上限，单位为tick
     WorkStealingQueue<Task> primary_queue_;                         // 内部队列信息
     WorkStealingQueue<Task> secondary_queue_;                       // 第二个队列，用于减少触锁概率，提升性能
     std::vector<ThreadPrimary *>* pool_threads_;                    // 用于存放线程池中的线程信息
     std::vector<int> steal_targets_;                                // 被偷的目标信息
+    int steal_size_ = 0;                                            // 构造 steal_targets_ 时的主线程数量
+    std::atomic<int>* pool_primary_size_ = nullptr;                 // 线程池当前生效的主线程数量
+    std::atomic<bool> retired_ {false};                             // 是否已经被回收
+    UtilsAtomicBitmap* pool_idle_mask_ = nullptr;                   // 线程池中空闲主线程的位图
+    bool is_idle_ = false;                                          // 本线程是否已在位图中标记为空闲
+    std::atomic<bool> parked_ {false};                              // 是否正在休眠，修改时需持有 mutex_
+    bool chain_wakeup_ = false;                                     // 本次是否被提交方唤醒，用于传递唤醒
+    std::atomic<unsigned long> wakeup_num_ {0};                     // 被唤醒的次数，由唤醒方写入
 
     std::mutex mutex_;
     std::condition_variable cv_;
 
     friend class ThreadPool;
+    friend class ThreadSecondary;
     friend class Allocator;
 };
 
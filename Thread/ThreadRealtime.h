@@ -0,0 +1,139 @@
+#ifndef THREADREALTIME_H
+#define THREADREALTIME_H
+
+#include "ThreadBase.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace ccy
+{
+
+/**
+ * 实时线程：独立于主线程和辅助线程，只执行自己收件箱中的任务，不参与窃取，也不读取pool中的队列
+ * 空闲时不休眠，持续轮询收件箱。绑定到调用方声明已隔离的cpu时，设置实时调度策略
+ * @notice 通过 ThreadPool::commitRealtime() 提交任务，适合数量少、耗时短、对延迟敏感的任务
+ */
+class ThreadRealtime: public ThreadBase{
+protected:
+    explicit ThreadRealtime(){
+        type_ = THREAD_TYPE_REALTIME;
+    }
+
+    Status init() override{
+        Status status;
+        ASSERT_INIT(false)
+        ASSERT_NOT_NULL(config_)
+        is_init_ = true;
+        done_ = true;
+        buildLatency();
+        thread_ = std::move(std::thread(&ThreadRealtime::run, this));
+        applyRealtime();
+        return status;
+    }
+
+    /**
+     * 设置pool的信息
+     * @param index 实时线程的序号
+     * @param cpu 绑定的cpu，为负数时不绑定
+     * @param config
+     * @return
+     */
+    Status setThreadPoolInfo(int index, int cpu, ThreadPoolConfigPtr config) {
+        Status status;
+        ASSERT_INIT(false)
+        ASSERT_NOT_NULL(config)
+        this->index_ = index;
+        this->cpu_ = cpu;
+        this->config_ = config;
+        return status;
+    }
+
+    Status run() override{
+        Status status;
+        ASSERT_INIT(true)
+        status = loopProcess();
+        return status;
+    }
+
+    void processTask() override {
+        Task task;
+        if (inbox_.tryPop(task)) {
+            stats_.recordLocalPop(1);
+            runTask(task);
+        } else {
+            idle();
+        }
+    }
+
+    void processTasks() override {
+        TaskArr tasks;
+        Task task;
+        while ((int)tasks.size() < config_->max_local_batch_size_ && inbox_.tryPop(task)) {
+            tasks.emplace_back(std::move(task));
+        }
+        if (!tasks.empty()) {
+            stats_.recordLocalPop(tasks.size());
+            runTasks(tasks);
+        } else {
+            idle();
+        }
+    }
+
+    /**
+     * 写入任务，可以被多个线程同时调用。实时线程持续轮询，无需唤醒
+     * @param task
+     */
+    void pushTask(Task&& task) {
+        inbox_.push(std::move(task));
+    }
+
+    /**
+     * 没有任务时的轮询方式：绑定到已隔离的cpu时仅 pause，否则 yield，避免与其他线程争抢同一个cpu
+     */
+    void idle() {
+        if (is_pinned_) {
+            UtilsTicker::relax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * 绑定cpu，并设置实时调度策略
+     * cpu 来自 realtime_thread_cpus_，线程池不会将其他线程移出该cpu，需由调用方保证其已隔离
+     * 只有成功绑定时才设置实时策略：实时线程持续轮询，若与其他线程共用cpu，会使其长时间得不到调度
+     * 任一步骤失败时，线程以普通调度策略继续运行，可通过 ThreadPool::getStats() 查看
+     */
+    void applyRealtime() {
+        is_pinned_ = false;
+        sched_applied_ = false;
+        if (cpu_ < 0) {
+            return;
+        }
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpu_, &cpuSet);
+        if (0 != pthread_setaffinity_np(thread_.native_handle(), sizeof(cpuSet), &cpuSet)) {
+            return;
+        }
+        is_pinned_ = true;
+        sched_applied_ = setSchedParam(config_->realtime_thread_policy_, config_->realtime_thread_priority_).isOK();
+    }
+
+private:
+    int index_ = 0;                                                 // 实时线程的序号
+    int cpu_ = -1;                                                  // 绑定的cpu，为负数时不绑定
+    std::atomic<bool> is_pinned_ {false};                           // 是否已绑定到调用方声明的cpu
+    std::atomic<bool> sched_applied_ {false};                       // 是否已设置实时调度策略
+    LockFreeMpscQueue<Task> inbox_;                                 // 收件箱，多个提交方写入，仅本线程读取
+
+    friend class ThreadPool;
+    friend class Allocator;
+};
+
+using ThreadRealtimePtr = ThreadRealtime *;
+
+}
+
+#endif
@@ -2,6 +2,9 @@
 #define THREADSECONDARY_H
 
 #include "ThreadBase.h"
+#include "ThreadPrimary.h"
+
+#include <vector>
 
 namespace ccy
 {
@@ -9,7 +12,6 @@ namespace ccy
 class ThreadSecondary: public ThreadBase{
 public:
     explicit ThreadSecondary(){
-        cur_ttl_ = 0;
         type_ = THREAD_TYPE_SECONDARY;
     }
 
@@ -19,10 +21,12 @@ protected:
         ASSERT_INIT(false)
         ASSERT_NOT_NULL(config_)
         
-        cur_ttl_ = config_->secondary_thread_ttl_;
+        last_active_ms_ = nowMs();
         is_init_ = true;
+        buildLatency();
+        buildTrace(trace_id_);
         thread_ = std::move(std::thread(&ThreadSecondary::run, this));
-        setSchedParam();
+        setSchedParam();                    // 失败时保持默认的调度策略
         return status;
     }
 
@@ -30,20 +34,33 @@ protected:
      * 设置pool的信息
      * @param poolTaskQueue
      * @param poolPriorityTaskQueue
+     * @param poolFairTaskQueue 带类别的任务队列
+     * @param poolDeadlineTaskQueue 带截止时间的任务队列
+     * @param poolThreads 主线程信息，用于窃取任务
+     * @param poolPrimarySize 当前生效的主线程数量
      * @param config
      * @return
      */
     Status setThreadPoolInfo(AtomicQueue<Task>* poolTaskQueue,
                               AtomicPriorityQueue<Task>* poolPriorityTaskQueue,
+                              FairTaskQueue* poolFairTaskQueue,
+                              DeadlineTaskQueue* poolDeadlineTaskQueue,
+                              std::vector<ThreadPrimary *>* poolThreads,
+                              std::atomic<int>* poolPrimarySize,
                               ThreadPoolConfigPtr config)
             {
                 Status status;
                 ASSERT_INIT(false)
-                ASSERT_NOT_NULL(poolTaskQueue, poolPriorityTaskQueue, config)
+                ASSERT_NOT_NULL(poolTaskQueue, poolPriorityTaskQueue, poolFairTaskQueue, poolDeadlineTaskQueue, poolThreads, poolPrimarySize, config)
 
                 this->pool_task_queue_ = poolTaskQueue;
                 this->pool_priority_task_queue_ = poolPriorityTaskQueue;
+                this->pool_fair_task_queue_ = poolFairTaskQueue;
+                this->pool_deadline_task_queue_ = poolDeadlineTaskQueue;
+                this->pool_threads_ = poolThreads;
+                this->pool_primary_size_ = poolPrimarySize;
                 this->config_ = config;
+                steal_cursor_ = ((unsigned int)((size_t)this >> 6)) | 1;    // 不同辅助线程的起始位置尽量分散，且随机数状态不能为0
                 return status;
             }
 
@@ -52,12 +69,13 @@ protected:
             ASSERT_INIT(true)
 
             status = loopProcess();
+            exited_.store(true, std::memory_order_release);
             return status;
     }
 
     void processTask() override {
         Task task;
-        if (popPoolTask(task)) {
+        if (popDeadlineTask(task) || popPoolTask(task) || stealTask(task)) {
             runTask(task);
         } else {
             // 如果任务无法获取，则稍加等待
@@ -72,14 +90,20 @@ protected:
      * @notice 目的是降低cpu的占用率
      */
     void waitRunTask(long ms) {
+        auto start = UtilsTicker::now();
+        recordTrace(TraceEventType::PARK, start);
         auto task = this->pool_task_queue_->popWithTimeout(ms);
+        auto end = UtilsTicker::now();
+        recordTrace(TraceEventType::UNPARK, end);
+        stats_.recordPark(end - start);
         if (nullptr != task) {
-            (*task)();
+            stats_.recordPoolPop(1);
+            runTask(*task);
         }
     }
     void processTasks() override {
         TaskArr tasks;
-        if (popPoolTask(tasks)) {
+        if (popDeadlineTask(tasks) || popPoolTask(tasks) || stealTask(tasks)) {
             runTasks(tasks);
         } else {
             waitRunTask(config_->queue_emtpy_interval_);
@@ -87,21 +111,128 @@ protected:
     }
     
     /**
-     * 判断本线程是否需要被自动释放
+     * 从主线程的本地队列中窃取一个任务
+     * @param task
+     * @return
+     */
+    bool stealTask(TaskRef task) {
+        return stealFromPrimary([&task](ThreadPrimary* target) {
+            return target->secondary_queue_.trySteal(task) || target->primary_queue_.trySteal(task);
+        });
+    }
+
+    /**
+     * 从主线程的本地队列中窃取一批任务
+     * @param tasks
+     * @return
+     */
+    bool stealTask(TaskArrRef tasks) {
+        return stealFromPrimary([this, &tasks](ThreadPrimary* target) {
+            bool result = target->secondary_queue_.trySteal(tasks, config_->max_steal_batch_size_);
+            auto leftSize = config_->max_steal_batch_size_ - tasks.size();
+            if (leftSize > 0) {
+                result |= target->primary_queue_.trySteal(tasks, leftSize);
+            }
+            return result;
+        });
+    }
+
+    /**
+     * 按照 secondary_steal_policy_ 选择被窃取的主线程
+     * 轮换和随机策略，仅决定起始位置，之后依次尝试所有主线程；最长队列策略，仅尝试队列最长的主线程
+     * @tparam StealFunc
+     * @param func
+     * @return
+     */
+    template<typename StealFunc>
+    bool stealFromPrimary(StealFunc&& func) {
+        int policy = config_->secondary_steal_policy_;
+        int size = pool_primary_size_->load(std::memory_order_acquire);
+        if (SECONDARY_STEAL_POLICY_NONE == policy || unlikely(size <= 0)) {
+            return false;
+        }
+
+        int begin = 0;
+        int attempts = size;
+        if (SECONDARY_STEAL_POLICY_LONGEST_QUEUE == policy) {
+            size_t longest = 0;
+            for (int i = 0; i < size; i++) {
+                auto* target = (*pool_threads_)[i];
+                size_t cur = target ? target->primary_queue_.getApproxSize() + target->secondary_queue_.getApproxSize() : 0;
+                if (cur > longest) {
+                    longest = cur;
+                    begin = i;
+                }
+            }
+            if (0 == longest) {
+                return false;                   // 所有主线程都没有积压，无需窃取
+            }
+            attempts = 1;
+        } else {
+            begin = (int)(nextCursor(policy) % (unsigned int)size);
+        }
+
+        for (int i = 0; i < attempts; i++) {
+            int index = (begin + i) % size;
+            auto* target = (*pool_threads_)[index];
+            if (likely(target) && func(target)) {
+                stats_.recordSteal(true);
+                recordTrace(TraceEventType::STEAL, UtilsTicker::now(), (unsigned int)index);
+                return true;
+            }
+        }
+        stats_.recordSteal(false);
+        return false;
+    }
+
+    /**
+     * 计算下一次窃取的起始位置
+     * @param policy
      * @return
      */
-    bool freeze(){
-        if(likely(is_running_)){
-            cur_ttl_++;
-            cur_ttl_ = std::min(cur_ttl_, config_->secondary_thread_ttl_);
-        }else{
-            cur_ttl_--;                                         // 如果当前线程没有在执行，则ttl-1
+    unsigned int nextCursor(int policy) {
+        if (SECONDARY_STEAL_POLICY_RANDOM == policy) {
+            // xorshift32
+            steal_cursor_ ^= steal_cursor_ << 13;
+            steal_cursor_ ^= steal_cursor_ >> 17;
+            steal_cursor_ ^= steal_cursor_ << 5;
+            return steal_cursor_;
         }
-        return cur_ttl_ <=0 && done_;                           // 必须是正在执行的线程，才可以被回收
+        return steal_cursor_++;
+    }
+
+    /**
+     * 判断本线程是否需要被自动释放，由监控线程调用
+     * @param calm 线程池当前是否处于低负载
+     * @return
+     * @notice 连续空闲（未执行任何任务）超过 secondary_thread_ttl_ 秒，且线程池处于低负载时，才会被回收
+     */
+    bool freeze(bool calm){
+        ThreadStatsInfo info;
+        stats_.snapshot(info);
+        long now = nowMs();
+        if (is_running_ || info.task_num_ != last_task_num_) {
+            last_task_num_ = info.task_num_;
+            last_active_ms_ = now;
+        }
+        return calm && done_                                       // 必须是正在执行的线程，才可以被回收
+               && now - last_active_ms_ >= config_->secondary_thread_ttl_ * 1000L;
+    }
+
+    static long nowMs() {
+        return (long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 
 private:
-    int cur_ttl_ = 0;                                              // 当前最大生存周期
+    std::vector<ThreadPrimary *>* pool_threads_ = nullptr;         // 主线程信息，用于窃取任务
+    std::atomic<int>* pool_primary_size_ = nullptr;                // 线程池当前生效的主线程数量
+    unsigned int steal_cursor_ = 1;                                // 窃取的起始位置（随机策略时为随机数状态）
+    unsigned long last_task_num_ = 0;                              // 上一次检查时，已执行的任务数量
+    long last_active_ms_ = 0;                                      // 最近一次观测到执行任务的时间，单位为ms
+    int trace_id_ = 0;                                             // 导出调度事件时使用的线程id，由线程池分配
+    bool is_compensate_ = false;                                   // 是否为阻塞区间的补偿线程
+    std::atomic<bool> exited_ {false};                             // 线程函数是否已经返回，此时回收无需等待
 
     friend class ThreadPool;
 };
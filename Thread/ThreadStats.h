@@ -0,0 +1,299 @@
+#ifndef THREADSTATS_H
+#define THREADSTATS_H
+
+#include "../ThreadObject.h"
+#include "../Utils/UtilsTicker.h"
+#include "../Utils/UtilsHistogram.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace ccy
+{
+
+/**
+ * 单个线程运行统计信息的快照
+ */
+struct ThreadStatsInfo {
+    int index_ = SECONDARY_THREAD_COMMON_ID;                        // 主线程（或实时线程）index，辅助线程为-1
+    int type_ = 0;                                                  // 线程类型
+    bool is_running_ = false;                                       // 读取时，是否正在执行任务
+    unsigned long task_num_ = 0;                                    // 执行的任务数量
+    unsigned long local_pop_num_ = 0;                               // 从本地队列获取的任务数量
+    unsigned long pool_pop_num_ = 0;                                // 从pool队列获取的任务数量
+    unsigned long steal_try_num_ = 0;                               // 尝试窃取的次数
+    unsigned long steal_num_ = 0;                                   // 窃取成功的次数
+    unsigned long busy_time_ = 0;                                   // 执行任务的总耗时，单位为ns
+    unsigned long wait_time_ = 0;                                   // 任务从入队到开始执行的总耗时，单位为ns
+    unsigned long park_num_ = 0;                                    // 进入休眠的次数
+    unsigned long park_time_ = 0;                                   // 休眠的总耗时，单位为ns
+    unsigned long local_queue_size_ = 0;                            // 本地队列的大致长度（仅主线程）
+};
+
+
+/**
+ * 监控线程（自动扩缩容）的决策信息
+ */
+struct ThreadMonitorInfo {
+    unsigned long tick_num_ = 0;                                    // 监控执行的轮数
+    unsigned long scale_up_num_ = 0;                                // 扩容的次数
+    unsigned long scale_up_thread_num_ = 0;                         // 扩容增加的辅助线程总数
+    unsigned long scale_down_thread_num_ = 0;                       // 回收的辅助线程总数
+    unsigned long backlog_ = 0;                                     // 最近一轮观测到的积压任务数量
+    unsigned long avg_wait_ = 0;                                    // 最近一轮完成任务的平均排队耗时，单位为ns
+    int pressure_ticks_ = 0;                                        // 当前连续处于高负载的轮数
+};
+
+
+/**
+ * 线程池整体运行统计信息的快照
+ */
+struct ThreadPoolStats {
+    std::vector<ThreadStatsInfo> primary_threads_;                  // 主线程信息
+    std::vector<ThreadStatsInfo> secondary_threads_;                // 辅助线程信息
+    std::vector<ThreadStatsInfo> realtime_threads_;                 // 实时线程信息
+    int realtime_pinned_num_ = 0;                                   // 成功绑定到声明cpu的实时线程数量
+    int realtime_sched_num_ = 0;                                    // 成功设置实时调度策略的实时线程数量
+    unsigned long pool_queue_size_ = 0;                             // pool中普通队列的大致长度
+    unsigned long priority_queue_size_ = 0;                         // pool中优先级队列的大致长度
+    unsigned long priority_queue_max_wait_ = 0;                     // 读取时，优先级队列中排队最久的任务已等待的时长，单位为ns
+    unsigned long priority_queue_peak_wait_ = 0;                    // 优先级队列中被执行的任务，历史最长的等待时长，单位为ns
+    ThreadMonitorInfo monitor_;                                     // 监控线程的决策信息
+    int blocking_thread_num_ = 0;                                   // 读取时，处于阻塞区间的线程数量
+    int compensate_thread_num_ = 0;                                 // 读取时，生效中的补偿线程数量
+    unsigned long compensate_spawn_num_ = 0;                        // 累计创建的补偿线程数量
+    unsigned long wakeup_num_ = 0;                                  // 累计唤醒休眠线程的次数，含主线程和pool的普通队列
+
+    /**
+     * 汇总所有线程的信息
+     * @return
+     */
+    ThreadStatsInfo total() const {
+        ThreadStatsInfo info;
+        for (const auto* arr : { &primary_threads_, &secondary_threads_, &realtime_threads_ }) {
+            for (const auto& cur : *arr) {
+                info.is_running_ |= cur.is_running_;
+                info.task_num_ += cur.task_num_;
+                info.local_pop_num_ += cur.local_pop_num_;
+                info.pool_pop_num_ += cur.pool_pop_num_;
+                info.steal_try_num_ += cur.steal_try_num_;
+                info.steal_num_ += cur.steal_num_;
+                info.busy_time_ += cur.busy_time_;
+                info.wait_time_ += cur.wait_time_;
+                info.park_num_ += cur.park_num_;
+                info.park_time_ += cur.park_time_;
+                info.local_queue_size_ += cur.local_queue_size_;
+            }
+        }
+        return info;
+    }
+};
+
+
+/**
+ * 单个线程的运行统计，仅由所属线程写入，独占cache line
+ * 写入时通过 seqlock 标记版本号，读取方无需加锁、无需暂停线程即可得到一致的快照
+ */
+class alignas(CACHE_LINE_SIZE) ThreadStats {
+public:
+    /**
+     * 记录执行的任务
+     * @param num
+     * @param busyTicks 执行耗时，单位为tick
+     * @param waitTicks 排队耗时，单位为tick
+     */
+    void recordTask(unsigned long num, unsigned long busyTicks, unsigned long waitTicks) {
+        update([&] {
+            inc(task_num_, num);
+            inc(busy_time_, busyTicks);
+            inc(wait_time_, waitTicks);
+        });
+    }
+
+    /**
+     * 记录从本地队列获取的任务
+     * @param num
+     */
+    void recordLocalPop(unsigned long num) {
+        update([&] { inc(local_pop_num_, num); });
+    }
+
+    /**
+     * 记录从pool队列获取的任务
+     * @param num
+     */
+    void recordPoolPop(unsigned long num) {
+        update([&] { inc(pool_pop_num_, num); });
+    }
+
+    /**
+     * 记录一次窃取
+     * @param success
+     */
+    void recordSteal(bool success) {
+        update([&] {
+            inc(steal_try_num_, 1);
+            inc(steal_num_, success ? 1 : 0);
+        });
+    }
+
+    /**
+     * 记录一次休眠
+     * @param parkTicks 休眠耗时，单位为tick
+     */
+    void recordPark(unsigned long parkTicks) {
+        update([&] {
+            inc(park_num_, 1);
+            inc(park_time_, parkTicks);
+        });
+    }
+
+    /**
+     * 获取一致的快照，可以在任意线程中调用
+     * @param info
+     */
+    void snapshot(ThreadStatsInfo& info) const {
+        while (true) {
+            unsigned long begin = seq_.load(std::memory_order_acquire);
+            info.task_num_ = task_num_.load(std::memory_order_relaxed);
+            info.local_pop_num_ = local_pop_num_.load(std::memory_order_relaxed);
+            info.pool_pop_num_ = pool_pop_num_.load(std::memory_order_relaxed);
+            info.steal_try_num_ = steal_try_num_.load(std::memory_order_relaxed);
+            info.steal_num_ = steal_num_.load(std::memory_order_relaxed);
+            info.busy_time_ = busy_time_.load(std::memory_order_relaxed);
+            info.wait_time_ = wait_time_.load(std::memory_order_relaxed);
+            info.park_num_ = park_num_.load(std::memory_order_relaxed);
+            info.park_time_ = park_time_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (likely(0 == (begin & 1) && begin == seq_.load(std::memory_order_relaxed))) {
+                break;
+            }
+            std::this_thread::yield();        // 写入方正在更新，稍后重试
+        }
+
+        // 内部以tick记录，对外统一换算成ns
+        info.busy_time_ = UtilsTicker::toNs(info.busy_time_);
+        info.wait_time_ = UtilsTicker::toNs(info.wait_time_);
+        info.park_time_ = UtilsTicker::toNs(info.park_time_);
+    }
+
+protected:
+    /**
+     * 以 seqlock 的方式更新数据，仅允许单一线程写入
+     * @tparam Func
+     * @param func
+     */
+    template<typename Func>
+    void update(Func&& func) {
+        unsigned long seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        func();
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * 单一写入方的累加，无需原子的 read-modify-write
+     */
+    static void inc(std::atomic<unsigned long>& value, unsigned long num) {
+        value.store(value.load(std::memory_order_relaxed) + num, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<unsigned long> seq_ {0};                            // 版本号，奇数表示正在写入
+    std::atomic<unsigned long> task_num_ {0};
+    std::atomic<unsigned long> local_pop_num_ {0};
+    std::atomic<unsigned long> pool_pop_num_ {0};
+    std::atomic<unsigned long> steal_try_num_ {0};
+    std::atomic<unsigned long> steal_num_ {0};
+    std::atomic<unsigned long> busy_time_ {0};
+    std::atomic<unsigned long> wait_time_ {0};
+    std::atomic<unsigned long> park_num_ {0};
+    std::atomic<unsigned long> park_time_ {0};
+};
+
+
+/**
+ * 任务延迟直方图的快照：按调度来源、按用户标签，分别统计排队耗时和执行耗时
+ */
+struct ThreadLatencyInfo {
+    UtilsHistogramInfo segment_wait_[TASK_SEGMENT_SIZE];            // 按来源统计的排队耗时
+    UtilsHistogramInfo segment_exec_[TASK_SEGMENT_SIZE];            // 按来源统计的执行耗时
+    UtilsHistogramInfo tag_wait_[MAX_TASK_TAG_SIZE];                // 按标签统计的排队耗时
+    UtilsHistogramInfo tag_exec_[MAX_TASK_TAG_SIZE];                // 按标签统计的执行耗时
+
+    /**
+     * 汇总所有来源的排队耗时
+     * @return
+     */
+    UtilsHistogramInfo totalWait() const {
+        UtilsHistogramInfo info;
+        for (const auto& cur : segment_wait_) {
+            info.merge(cur);
+        }
+        return info;
+    }
+
+    /**
+     * 汇总所有来源的执行耗时
+     * @return
+     */
+    UtilsHistogramInfo totalExec() const {
+        UtilsHistogramInfo info;
+        for (const auto& cur : segment_exec_) {
+            info.merge(cur);
+        }
+        return info;
+    }
+};
+
+
+/**
+ * 单个线程的任务延迟直方图，仅由所属线程写入
+ */
+class ThreadLatency {
+public:
+    /**
+     * 记录一个任务
+     * @param segment
+     * @param tag
+     * @param waitTicks
+     * @param execTicks
+     */
+    void record(int segment, int tag, unsigned long waitTicks, unsigned long execTicks) {
+        if (likely(segment >= 0 && segment < TASK_SEGMENT_SIZE)) {
+            segment_wait_[segment].record(waitTicks);
+            segment_exec_[segment].record(execTicks);
+        }
+        if (likely(tag >= 0 && tag < MAX_TASK_TAG_SIZE)) {
+            tag_wait_[tag].record(waitTicks);
+            tag_exec_[tag].record(execTicks);
+        }
+    }
+
+    /**
+     * 合并到快照中，可以在任意线程中调用
+     * @param info
+     */
+    void snapshot(ThreadLatencyInfo& info) const {
+        for (int i = 0; i < TASK_SEGMENT_SIZE; i++) {
+            segment_wait_[i].snapshot(info.segment_wait_[i]);
+            segment_exec_[i].snapshot(info.segment_exec_[i]);
+        }
+        for (int i = 0; i < MAX_TASK_TAG_SIZE; i++) {
+            tag_wait_[i].snapshot(info.tag_wait_[i]);
+            tag_exec_[i].snapshot(info.tag_exec_[i]);
+        }
+    }
+
+private:
+    UtilsHistogram segment_wait_[TASK_SEGMENT_SIZE];
+    UtilsHistogram segment_exec_[TASK_SEGMENT_SIZE];
+    UtilsHistogram tag_wait_[MAX_TASK_TAG_SIZE];
+    UtilsHistogram tag_exec_[MAX_TASK_TAG_SIZE];
+};
+
+}
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef THREADTRACE_H
+#define THREADTRACE_H
+
+#include "../ThreadObject.h"
+#include "../Utils/UtilsTicker.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+
+namespace ccy
+{
+
+enum class TraceEventType {
+    TASK_START = 1,             // 开始执行任务，arg 为 segment | tag << 8
+    TASK_END = 2,               // 任务执行结束
+    STEAL = 3,                  // 窃取成功，arg 为被窃取的线程index
+    PARK = 4,                   // 进入休眠
+    UNPARK = 5,                 // 结束休眠
+    SECONDARY_SPAWN = 6,        // 创建辅助线程，arg 为辅助线程的 trace id
+    SECONDARY_FREEZE = 7,       // 回收辅助线程，arg 为辅助线程的 trace id
+};
+
+
+/**
+ * 导出时使用的事件信息
+ */
+struct TraceEventInfo {
+    unsigned long ts_ = 0;                                          // 事件发生时的tick
+    int tid_ = 0;                                                   // 事件所属的 trace id
+    TraceEventType type_ = TraceEventType::TASK_START;
+    unsigned int arg_ = 0;
+};
+
+
+/**
+ * 固定大小的事件环形缓冲区，写满后覆盖最早的事件
+ * 每个事件占用16字节，写入时没有锁，也没有 read-modify-write 原子操作
+ */
+class ThreadTrace {
+public:
+    /**
+     * @param tid 所属线程的 trace id
+     * @param capacity 事件数量，向上取整为2的幂次
+     */
+    explicit ThreadTrace(int tid, unsigned int capacity) {
+        unsigned long size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        tid_ = tid;
+        mask_ = size - 1;
+        slots_.reset(new Slot[size]());
+    }
+
+    /**
+     * 写入一个事件，仅允许所属线程调用
+     * @param type
+     * @param arg
+     */
+    void record(TraceEventType type, unsigned int arg = 0) {
+        record(type, UtilsTicker::now(), arg);
+    }
+
+    /**
+     * 写入一个事件，复用调用方已经获取的tick，仅允许所属线程调用
+     * @param type
+     * @param ts
+     * @param arg
+     */
+    void record(TraceEventType type, unsigned long ts, unsigned int arg) {
+        unsigned long pos = head_.load(std::memory_order_relaxed);
+        write(slots_[pos & mask_], type, ts, arg);
+        head_.store(pos + 1, std::memory_order_release);
+    }
+
+    /**
+     * 写入一个事件，允许多个线程同时调用
+     * @param type
+     * @param arg
+     */
+    void recordConcurrent(TraceEventType type, unsigned int arg = 0) {
+        unsigned long pos = head_.fetch_add(1, std::memory_order_relaxed);
+        write(slots_[pos & mask_], type, UtilsTicker::now(), arg);
+    }
+
+    /**
+     * 导出缓冲区中仍然保留的事件（按写入顺序）
+     * @param events
+     * @notice 写入过程中导出，可能读取到部分被覆盖的事件
+     */
+    void dump(std::vector<TraceEventInfo>& events) const {
+        unsigned long head = head_.load(std::memory_order_acquire);
+        unsigned long begin = head > mask_ + 1 ? head - mask_ - 1 : 0;
+        for (unsigned long pos = begin; pos < head; pos++) {
+            const auto& slot = slots_[pos & mask_];
+            TraceEventInfo info;
+            info.ts_ = slot.ts_.load(std::memory_order_relaxed);
+            unsigned long data = slot.data_.load(std::memory_order_relaxed);
+            if (0 == info.ts_ || 0 == data) {
+                continue;
+            }
+            info.tid_ = tid_;
+            info.type_ = (TraceEventType)(data & 0xFF);
+            info.arg_ = (unsigned int)(data >> 32);
+            events.emplace_back(info);
+        }
+    }
+
+    int getTid() const {
+        return tid_;
+    }
+
+    NO_ALLOWED_COPY(ThreadTrace)
+
+protected:
+    struct Slot {
+        std::atomic<unsigned long> ts_;
+        std::atomic<unsigned long> data_;                          // 低8位为事件类型，高32位为参数
+    };
+
+    static void write(Slot& slot, TraceEventType type, unsigned long ts, unsigned int arg) {
+        slot.ts_.store(ts, std::memory_order_relaxed);
+        slot.data_.store((unsigned long)type | ((unsigned long)arg << 32), std::memory_order_relaxed);
+    }
+
+private:
+    int tid_ = 0;
+    unsigned long mask_ = 0;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<unsigned long> head_ {0};                          // 下一个写入的位置
+};
+
+/**
+ * 单个线程导出的全部事件
+ */
+struct TraceThreadInfo {
+    int tid_ = 0;                                                   // trace id
+    std::string name_;                                              // 展示的线程名称
+    std::vector<TraceEventInfo> events_;                            // 按写入顺序排列的事件
+};
+
+
+/**
+ * 将事件写成 Chrome trace-event 格式的json，可以在 chrome://tracing 或 ui.perfetto.dev 中直接打开
+ * 任务和休眠的开始/结束事件合并成一个区间（ph = X），缓冲区覆盖后无法配对的事件直接丢弃
+ */
+class ThreadTraceWriter {
+public:
+    /**
+     * 写入文件
+     * @param threads
+     * @param path
+     * @return
+     */
+    static Status write(const std::vector<TraceThreadInfo>& threads, const std::string& path) {
+        Status status;
+        std::ofstream out(path, std::ios::out | std::ios::trunc);
+        RETURN_ERROR_STATUS_BY_CONDITION(!out.is_open(), "open trace file [" + path + "] failed")
+
+        unsigned long base = 0;
+        for (const auto& thd : threads) {
+            for (const auto& event : thd.events_) {
+                base = (0 == base) ? event.ts_ : std::min(base, event.ts_);
+            }
+        }
+
+        bool first = true;
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        for (const auto& thd : threads) {
+            append(out, first) << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << thd.tid_
+                               << ",\"name\":\"thread_name\",\"args\":{\"name\":\"" << thd.name_ << "\"}}";
+            append(out, first) << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << thd.tid_
+                               << ",\"name\":\"thread_sort_index\",\"args\":{\"sort_index\":" << thd.tid_ << "}}";
+
+            const TraceEventInfo* taskStart = nullptr;
+            const TraceEventInfo* parkStart = nullptr;
+            for (const auto& event : thd.events_) {
+                switch (event.type_) {
+                    case TraceEventType::TASK_START: taskStart = &event; break;
+                    case TraceEventType::PARK: parkStart = &event; break;
+                    case TraceEventType::TASK_END:
+                        if (taskStart) {
+                            writeSlice(append(out, first), thd.tid_, segmentName(taskStart->arg_ & 0xFF),
+                                       base, taskStart->ts_, event.ts_)
+                                    << ",\"args\":{\"tag\":" << (taskStart->arg_ >> 8) << "}}";
+                            taskStart = nullptr;
+                        }
+                        break;
+                    case TraceEventType::UNPARK:
+                        if (parkStart) {
+                            writeSlice(append(out, first), thd.tid_, "park", base, parkStart->ts_, event.ts_) << "}";
+                            parkStart = nullptr;
+                        }
+                        break;
+                    case TraceEventType::STEAL:
+                        writeInstant(append(out, first), thd.tid_, "steal", base, event.ts_)
+                                << ",\"args\":{\"victim\":" << event.arg_ << "}}";
+                        break;
+                    case TraceEventType::SECONDARY_SPAWN:
+                    case TraceEventType::SECONDARY_FREEZE:
+                        writeInstant(append(out, first), thd.tid_,
+                                     TraceEventType::SECONDARY_SPAWN == event.type_ ? "secondary_spawn" : "secondary_freeze",
+                                     base, event.ts_)
+                                << ",\"args\":{\"thread\":" << event.arg_ << "}}";
+                        break;
+                    default: break;
+                }
+            }
+        }
+        out << "]}\n";
+        out.flush();
+        RETURN_ERROR_STATUS_BY_CONDITION(!out.good(), "write trace file [" + path + "] failed")
+        return status;
+    }
+
+protected:
+    static std::ofstream& append(std::ofstream& out, bool& first) {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        return out;
+    }
+
+    /**
+     * 将tick换算成相对起点的us，保留到ns精度
+     */
+    static double toUs(unsigned long base, unsigned long ts) {
+        return ts > base ? (double)UtilsTicker::toNs(ts - base) / 1000.0 : 0.0;
+    }
+
+    static std::ofstream& writeSlice(std::ofstream& out, int tid, const char* name,
+                                     unsigned long base, unsigned long start, unsigned long end) {
+        out << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << tid << ",\"name\":\"" << name << "\",\"ts\":"
+            << std::fixed << toUs(base, start) << ",\"dur\":" << (end > start ? toUs(start, end) : 0.0);
+        return out;
+    }
+
+    static std::ofstream& writeInstant(std::ofstream& out, int tid, const char* name,
+                                       unsigned long base, unsigned long ts) {
+        out << "{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << tid << ",\"name\":\"" << name
+            << "\",\"ts\":" << std::fixed << toUs(base, ts);
+        return out;
+    }
+
+    static const char* segmentName(unsigned int segment) {
+        switch (segment) {
+            case TASK_SEGMENT_LOCAL: return "task_local";
+            case TASK_SEGMENT_POOL: return "task_pool";
+            case TASK_SEGMENT_LONG_TIME: return "task_long_time";
+            case TASK_SEGMENT_PRIORITY: return "task_priority";
+            case TASK_SEGMENT_FAIR: return "task_fair";
+            case TASK_SEGMENT_DEADLINE: return "task_deadline";
+            case TASK_SEGMENT_REALTIME: return "task_realtime";
+            default: return "task";
+        }
+    }
+};
+
+}
+
+#endif
@@ -1,6 +1,12 @@
 #include "ThreadPool.h"
 #include "./Utils/UtilsDefine.h"
 #include "Allocator.h"
+#include "Executor/SerialExecutor.h"
+#include "Reactor/Reactor.h"
+#include "AsyncIo/AsyncIo.h"
+#include "Fiber/Fiber.h"
+#include "Executor/SharedQueueBridge.h"
+#include "Phaser/Phaser.h"
 #include <vector>
 
 namespace ccy
@@ -18,7 +24,11 @@ ThreadPool::ThreadPool(bool autoInit, const ThreadPoolConfig& config) noexcept
 
 ThreadPool::~ThreadPool()
     {
-        this->config_.monitor_enable_ = false;
+        {
+            LOCK_GUARD lock(monitor_mutex_);
+            this->config_.monitor_enable_ = false;
+        }
+        monitor_cv_.notify_all();
         if(monitor_thread_.joinable()){
             monitor_thread_.join();
         }
@@ -30,6 +40,7 @@ Status ThreadPool::setConfig(const ThreadPoolConfig &config) {
     ASSERT_INIT(false)    // 初始化后，无法设置参数信息
 
     this->config_ = config;
+    this->config_.convertDeprecated();
     return status;
 }
 
@@ -38,30 +49,80 @@ Status ThreadPool::init(){
     if(is_init_){
         return status;
     }
+    if (config_.trace_enable_) {
+        // pool 级别的事件，使用 max_thread_size_ 作为 trace id，辅助线程依次排在后面
+        trace_.reset(new ThreadTrace(config_.max_thread_size_, (unsigned int)config_.trace_buffer_size_));
+    }
+    priority_task_queue_.setAging(config_.priority_aging_rate_, config_.priority_aging_cap_);
+    fair_task_queue_.setRunnableCallback([this] { wakeupIdlePrimary(); });
+    if (config_.auto_route_enable_) {
+        profiler_.setThreshold(config_.auto_route_promote_threshold_, config_.auto_route_demote_threshold_);
+    }
     monitor_thread_ = std::move(std::thread(&ThreadPool::monitor, this));
     thread_record_map_.clear();
-    primary_threads_.reserve(config_.default_thread_size_);
-    for(int i = 0; i < config_.default_thread_size_; i++){
+    /**
+     * 按照 max_thread_size_ 一次性创建所有主线程对象，之后 primary_threads_ 不再变化，读取时无需加锁
+     * 仅前 default_thread_size_ 个线程启动，其余的通过 resizePrimaryThread() 启动
+     */
+    int slotSize = std::max(config_.max_thread_size_, config_.default_thread_size_);
+    primary_size_.store(config_.default_thread_size_, std::memory_order_release);
+    idle_mask_.reset(slotSize);
+    primary_threads_.reserve(slotSize);
+    for(int i = 0; i < slotSize; i++){
         auto ptr = SAFE_MALLOC_OBJECT(ThreadPrimary);
-        ptr->setThreadPoolInfo(i, &task_queue_, &primary_threads_, &config_);
+        ptr->setThreadPoolInfo(i, &task_queue_, &fair_task_queue_, &deadline_task_queue_, &primary_threads_, &primary_size_, &idle_mask_, &config_);
     
         // 记录线程和匹配id信息
         thread_record_map_[(size_t)std::hash<std::thread::id>{}(ptr->thread_.get_id())] = i;
         primary_threads_.emplace_back(ptr);
     }
 
-    for (auto* pt : primary_threads_) {
-        status += pt->init();
+    for (int i = 0; i < config_.default_thread_size_; i++) {
+        status += primary_threads_[i]->init();
     }
+    primary_peak_size_.store(config_.default_thread_size_, std::memory_order_release);
 
     FUNCTION_CHECK_STATUS
     status = createSecondaryThread(config_.secondary_thread_size_);
     FUNCTION_CHECK_STATUS
+    status = createRealtimeThread();
+    FUNCTION_CHECK_STATUS
+
+    if (config_.reactor_thread_size_ > 0) {
+        reactor_.reset(new Reactor(this));
+        status = reactor_->init(config_.reactor_thread_size_);
+        FUNCTION_CHECK_STATUS
+    }
 
     is_init_ = true;
     return status;
 }
 
+Status ThreadPool::commitPhase(Phaser* phaser, const std::function<void(int party)>& func, int tag){
+    Status status;
+    ASSERT_INIT(true)
+    ASSERT_NOT_NULL(phaser)
+    RETURN_ERROR_STATUS_BY_CONDITION(!func, "phase function is empty")
+
+    // 同一轮的任务共享一份函数，避免逐个拷贝
+    auto shared = std::make_shared<std::function<void(int)>>(func);
+    TaskArr tasks;
+    tasks.reserve(phaser->getParties());
+    for (int party = 0; party < phaser->getParties(); party++) {
+        tasks.emplace_back([phaser, shared, party] {
+            // 异常时同样到达，否则本轮永远无法结束
+            try {
+                (*shared)(party);
+            } catch (...) {
+                phaser->recordError();
+            }
+            phaser->arrive(party);
+        });
+    }
+    pushTasks(tasks, tag);
+    return status;
+}
+
 Status ThreadPool::submit(const TaskGroup& taskGroup, long ttl){
     Status status;
     ASSERT_INIT(true)
@@ -112,24 +173,67 @@ Status ThreadPool::destroy(){
     if(!is_init_){
         return status;
     }
-    // delete primary
-    for(auto &pt : primary_threads_){
-        status += pt->destroy();
+    // 先停止 reactor，不再向主线程分发就绪事件。已分发的回调会访问 reactor，待主线程停止后再释放
+    if (reactor_) {
+        status += reactor_->destroy();
     }
+    {
+        LOCK_GUARD lock(shared_mutex_);
+        shared_bridges_.clear();
+    }
+    {
+        // 等待处理中的异步 io 完成，完成回调已写入线程池
+        LOCK_GUARD lock(async_io_mutex_);
+        async_io_.reset();
+    }
+    // 实时线程收件箱中剩余的任务不再执行，对应 future 的 get() 会抛出 broken_promise
+    for (auto &rt : realtime_threads_) {
+        status += rt->destroy();
+        DELETE_PTR(rt)
+    }
+    realtime_threads_.clear();
     FUNCTION_CHECK_STATUS
-    
+
+    /**
+     * 先对外发布主线程数量为0，辅助线程不再访问 primary_threads_，提交的任务改为写入 pool 的队列
+     * 已经被回收的主线程无需再次 destroy
+     */
+    int primarySize = primary_size_.exchange(0, std::memory_order_seq_cst);
+    for (int i = 0; i < primarySize; i++) {
+        status += primary_threads_[i]->destroy();
+    }
+    FUNCTION_CHECK_STATUS
+
+    /**
+     * 辅助线程在此之前可能已经读取到旧的数量，正在窃取主线程的任务，需在其退出后才能释放主线程
+     * 辅助线程中执行的任务可能进入 BlockingScope，创建新的补偿线程，故循环取出，直到没有新增
+     */
+    while (true) {
+        std::list<std::unique_ptr<ThreadSecondary>> secondaries;
+        {
+            LOCK_GUARD lock(st_mutex_);
+            secondaries.swap(secondary_threads_);
+        }
+        if (secondaries.empty()) {
+            break;
+        }
+        for (auto &st : secondaries) {
+            status += st->destroy();
+        }
+        FUNCTION_CHECK_STATUS
+    }
+
     for (auto &pt : primary_threads_) {
         DELETE_PTR(pt)
     }
     primary_threads_.clear();
-
-    // secondary is intel
-    for(auto &st: secondary_threads_){
-        status += st->destroy();
-    }
-    FUNCTION_CHECK_STATUS
-    secondary_threads_.clear();
+    primary_peak_size_.store(0, std::memory_order_release);
     thread_record_map_.clear();
+    reactor_.reset();
+    {
+        LOCK_GUARD lock(strand_mutex_);
+        strands_.clear();
+    }
     is_init_ = false;
 
     return status;
@@ -139,12 +243,388 @@ bool ThreadPool::isInit() const{
     return is_init_;
 }
 
+ThreadPoolStats ThreadPool::getStats(){
+    ThreadPoolStats stats;
+    stats.pool_queue_size_ = task_queue_.getApproxSize();
+    stats.priority_queue_size_ = priority_task_queue_.getApproxSize();
+    stats.priority_queue_max_wait_ = priority_task_queue_.getMaxWait();
+    stats.priority_queue_peak_wait_ = priority_task_queue_.getPeakWait();
+
+    int primarySize = primary_size_.load(std::memory_order_acquire);
+    stats.primary_threads_.resize(primarySize);
+    for (int i = 0; i < primarySize; i++) {
+        auto& info = stats.primary_threads_[i];
+        auto* pt = primary_threads_[i];
+        pt->snapshotStats(info);
+        info.index_ = pt->index_;
+        info.local_queue_size_ = pt->primary_queue_.getApproxSize() + pt->secondary_queue_.getApproxSize();
+    }
+
+    {
+        LOCK_GUARD lock(monitor_mutex_);
+        stats.monitor_ = monitor_info_;
+    }
+    stats.blocking_thread_num_ = blocking_num_.load();
+    stats.compensate_thread_num_ = compensate_num_.load();
+    stats.compensate_spawn_num_ = compensate_spawn_num_.load();
+    stats.wakeup_num_ = task_queue_.getNotifyNum();
+    for (int i = 0; i < primary_peak_size_.load(std::memory_order_acquire); i++) {
+        stats.wakeup_num_ += primary_threads_[i]->wakeup_num_.load(std::memory_order_relaxed);
+    }
+
+    for (auto* rt : realtime_threads_) {
+        ThreadStatsInfo info;
+        rt->snapshotStats(info);
+        info.index_ = rt->index_;
+        stats.realtime_threads_.emplace_back(info);
+        stats.realtime_pinned_num_ += rt->is_pinned_.load(std::memory_order_relaxed) ? 1 : 0;
+        stats.realtime_sched_num_ += rt->sched_applied_.load(std::memory_order_relaxed) ? 1 : 0;
+    }
+
+    LOCK_GUARD lock(st_mutex_);
+    for (auto& st : secondary_threads_) {
+        ThreadStatsInfo info;
+        st->snapshotStats(info);
+        stats.secondary_threads_.emplace_back(info);
+    }
+    return stats;
+}
+
+ScratchArena* ThreadPool::currentArena(){
+    auto* cur = ThreadBase::current();
+    return nullptr == cur ? nullptr : cur->getArena();
+}
+
+ThreadLatencyInfo ThreadPool::getLatency(){
+    ThreadLatencyInfo info;
+    // 已回收的主线程，仍保留历史数据
+    int peakSize = primary_peak_size_.load(std::memory_order_acquire);
+    for (int i = 0; i < peakSize; i++) {
+        auto* pt = primary_threads_[i];
+        if (pt->latency_) {
+            pt->latency_->snapshot(info);
+        }
+    }
+
+    for (auto* rt : realtime_threads_) {
+        if (rt->latency_) {
+            rt->latency_->snapshot(info);
+        }
+    }
+
+    LOCK_GUARD lock(st_mutex_);
+    for (auto& st : secondary_threads_) {
+        if (st->latency_) {
+            st->latency_->snapshot(info);
+        }
+    }
+    return info;
+}
+
+Status ThreadPool::dumpTrace(const std::string& path){
+    Status status;
+    RETURN_ERROR_STATUS_BY_CONDITION(!config_.trace_enable_, "trace is not enabled")
+
+    std::vector<TraceThreadInfo> threads;
+    auto collect = [&threads](const ThreadTrace* trace, const std::string& name) {
+        if (nullptr == trace) {
+            return;
+        }
+        TraceThreadInfo info;
+        info.tid_ = trace->getTid();
+        info.name_ = name;
+        trace->dump(info.events_);
+        threads.emplace_back(std::move(info));
+    };
+
+    int peakSize = primary_peak_size_.load(std::memory_order_acquire);
+    for (int i = 0; i < peakSize; i++) {
+        collect(primary_threads_[i]->trace_.get(), "primary_" + std::to_string(i));
+    }
+    {
+        LOCK_GUARD lock(st_mutex_);
+        for (auto& st : secondary_threads_) {
+            collect(st->trace_.get(), "secondary_" + std::to_string(st->trace_id_));
+        }
+        for (auto& trace : retired_traces_) {
+            collect(trace.get(), "secondary_" + std::to_string(trace->getTid()) + "(retired)");
+        }
+    }
+    collect(trace_.get(), "pool");
+
+    return ThreadTraceWriter::write(threads, path);
+}
+
+std::list<std::unique_ptr<ThreadSecondary>>::iterator ThreadPool::retireSecondaryThread(
+        std::list<std::unique_ptr<ThreadSecondary>>::iterator iter){
+    auto& st = *iter;
+    if (st->is_compensate_ && st->done_) {
+        compensate_num_--;          // 补偿线程在阻塞区间结束之前被回收
+    }
+    if (trace_) {
+        trace_->recordConcurrent(TraceEventType::SECONDARY_FREEZE, (unsigned int)st->trace_id_);
+    }
+    if (st->trace_) {
+        st->reset();            // 先等待线程退出，之后才能转移事件记录
+        retired_traces_.emplace_back(std::move(st->trace_));
+        if (retired_traces_.size() > (size_t)MAX_RETIRED_TRACE_SIZE) {
+            retired_traces_.pop_front();
+        }
+    }
+    return secondary_threads_.erase(iter);
+}
+
+Status ThreadPool::resizePrimaryThread(int size){
+    Status status;
+    ASSERT_INIT(true)
+    LOCK_GUARD lock(st_mutex_);        // 与辅助线程的增删互斥，确保总数不超过 max_thread_size_
+    RETURN_ERROR_STATUS_BY_CONDITION((size <= 0 || size + (int)secondary_threads_.size() > config_.max_thread_size_), \
+                "cannot resize primary thread to [" + std::to_string(size) + "], "    \
+                + "[" + std::to_string(secondary_threads_.size()) + "] secondary thread running.")
+
+    int curSize = primary_size_.load(std::memory_order_acquire);
+    if (size > curSize) {
+        // 先启动线程，再对外发布数量。新线程的 steal 范围，在发布后自行更新
+        for (int i = curSize; i < size; i++) {
+            primary_threads_[i]->retired_.store(false, std::memory_order_seq_cst);
+            status += primary_threads_[i]->init();
+        }
+        FUNCTION_CHECK_STATUS
+        if (size > primary_peak_size_.load(std::memory_order_relaxed)) {
+            primary_peak_size_.store(size, std::memory_order_release);
+        }
+        primary_size_.store(size, std::memory_order_seq_cst);
+    } else {
+        // 先对外发布数量，停止向待回收的线程分发任务，再从 index 最大的线程开始回收
+        primary_size_.store(size, std::memory_order_seq_cst);
+        for (int i = curSize - 1; i >= size; i--) {
+            status += primary_threads_[i]->retire();
+        }
+    }
+    return status;
+}
+
+std::shared_ptr<SerialExecutor> ThreadPool::strand(const std::string& key){
+    LOCK_GUARD lock(strand_mutex_);
+    auto& executor = strands_[key];
+    if (nullptr == executor) {
+        executor = std::make_shared<SerialExecutor>(this);
+    }
+    return executor;
+}
+
+Status ThreadPool::releaseStrand(const std::string& key){
+    Status status;
+    LOCK_GUARD lock(strand_mutex_);
+    RETURN_ERROR_STATUS_BY_CONDITION((0 == strands_.erase(key)), "strand [" + key + "] is not exist")
+    return status;
+}
+
+TaskClassHandle ThreadPool::createTaskClass(const std::string& name, int weight, int maxConcurrency){
+    TaskClassHandle handle;
+    handle.index_ = fair_task_queue_.addClass(name, weight, maxConcurrency);
+    handle.name_ = name;
+    return handle;
+}
+
+std::vector<TaskClassInfo> ThreadPool::getTaskClassStats(){
+    std::vector<TaskClassInfo> infos;
+    fair_task_queue_.snapshot(infos);
+    return infos;
+}
+
+std::vector<TaskProfileInfo> ThreadPool::getTaskProfiles(){
+    std::vector<TaskProfileInfo> infos;
+    profiler_.snapshot(infos);
+    return infos;
+}
+
+DeadlineTaskInfo ThreadPool::getDeadlineStats(){
+    DeadlineTaskInfo info;
+    deadline_task_queue_.snapshot(info);
+    return info;
+}
+
+int ThreadPool::getPrimaryThreadSize() const{
+    return primary_size_.load(std::memory_order_acquire);
+}
+
+Reactor* ThreadPool::getReactor() const{
+    return reactor_.get();
+}
+
+void ThreadPool::pushTasks(TaskArr& tasks, int tag){
+    if (tasks.empty()) {
+        return;
+    }
+    int realIndex = dispatch(DEFAULT_TASK_STRATEGY);
+    bool local = realIndex >= 0 && realIndex < primary_size_.load(std::memory_order_acquire);
+    for (auto& task : tasks) {
+        task.setTrace(local ? TASK_SEGMENT_LOCAL : TASK_SEGMENT_POOL, tag);
+    }
+    if (local) {
+        primary_threads_[realIndex]->pushTasks(tasks);
+    } else {
+        task_queue_.push(tasks);
+        wakeupIdlePrimary();
+    }
+}
+
+void ThreadPool::pushCompletionTask(Task&& task){
+    int realIndex = dispatch(DEFAULT_TASK_STRATEGY);
+    if (realIndex >= 0 && realIndex < primary_size_.load(std::memory_order_acquire)) {
+        primary_threads_[realIndex]->pushTask(std::move(task.setTrace(TASK_SEGMENT_LOCAL, DEFAULT_TASK_TAG)));
+    } else {
+        task_queue_.push(std::move(task.setTrace(TASK_SEGMENT_POOL, DEFAULT_TASK_TAG)));
+        wakeupIdlePrimary();
+    }
+}
+
+void ThreadPool::spawnFiber(Task&& body, int tag){
+    auto* fiber = new Fiber(this, std::move(body), (size_t)config_.fiber_stack_size_, tag);
+    int realIndex = dispatch(DEFAULT_TASK_STRATEGY);
+    Task task([fiber] { fiber->resume(); });
+    if (realIndex >= 0 && realIndex < primary_size_.load(std::memory_order_acquire)) {
+        primary_threads_[realIndex]->pushTask(std::move(task.setTrace(TASK_SEGMENT_LOCAL, tag)));
+    } else {
+        task_queue_.push(std::move(task.setTrace(TASK_SEGMENT_POOL, tag)));
+        wakeupIdlePrimary();
+    }
+}
+
+void ThreadPool::scheduleFiber(Fiber* fiber){
+    Task task([fiber] { fiber->resume(); });
+    auto* cur = ThreadBase::current();
+    if (nullptr != cur && THREAD_TYPE_PRIMARY == cur->type_) {
+        auto* pt = static_cast<ThreadPrimary*>(cur);
+        if (pt->index_ < primary_size_.load(std::memory_order_acquire) && primary_threads_[pt->index_] == pt) {
+            task.setTrace(TASK_SEGMENT_LOCAL, fiber->tag_);
+            if (fiber->wait_ready_) {
+                pt->pushWaiting(std::move(fiber->wait_ready_), std::move(task));      // await() 中挂起，就绪后再调度
+            } else {
+                pt->pushTask(std::move(task));
+            }
+            return;
+        }
+    }
+    pushCompletionTask(std::move(task));
+}
+
+AsyncIo* ThreadPool::getAsyncIo(){
+    LOCK_GUARD lock(async_io_mutex_);
+    if (!async_io_ && is_init_) {
+        std::unique_ptr<AsyncIo> io(new AsyncIo(this));
+        if (io->init(config_.async_io_uring_enable_, config_.async_io_thread_size_,
+                     config_.async_io_queue_depth_).isOK()) {
+            async_io_ = std::move(io);
+        }
+    }
+    return async_io_.get();
+}
+
+std::future<long> ThreadPool::commitAsyncIo(int op, int fd, long offset, void* buf, size_t len,
+                                            const std::function<void(long)>& onFinished){
+    AsyncIo* io = getAsyncIo();
+    if (unlikely(nullptr == io)) {
+        std::promise<long> promise;
+        promise.set_value(-EINVAL);
+        return promise.get_future();
+    }
+    return io->submit(op, fd, offset, buf, len, onFinished);
+}
+
+std::future<long> ThreadPool::readAsync(int fd, long offset, void* buf, size_t len,
+                                        const std::function<void(long)>& onFinished){
+    return commitAsyncIo(ASYNC_IO_READ, fd, offset, buf, len, onFinished);
+}
+
+std::future<long> ThreadPool::writeAsync(int fd, long offset, const void* buf, size_t len,
+                                         const std::function<void(long)>& onFinished){
+    return commitAsyncIo(ASYNC_IO_WRITE, fd, offset, const_cast<void*>(buf), len, onFinished);
+}
+
+Status ThreadPool::bindSharedQueue(SharedMemoryQueue* queue,
+                                   const std::function<void(const SharedTaskDesc&)>& handler){
+    Status status;
+    ASSERT_INIT(true)
+    ASSERT_NOT_NULL(queue)
+
+    LOCK_GUARD lock(shared_mutex_);
+    RETURN_ERROR_STATUS_BY_CONDITION(shared_bridges_.count(queue) > 0, "shared queue is already bound")
+    std::unique_ptr<SharedQueueBridge> bridge(new SharedQueueBridge(this, queue, handler));
+    status = bridge->init();
+    FUNCTION_CHECK_STATUS
+    shared_bridges_[queue] = std::move(bridge);
+    return status;
+}
+
+Status ThreadPool::unbindSharedQueue(SharedMemoryQueue* queue){
+    Status status;
+    std::unique_ptr<SharedQueueBridge> bridge;
+    {
+        LOCK_GUARD lock(shared_mutex_);
+        auto iter = shared_bridges_.find(queue);
+        RETURN_ERROR_STATUS_BY_CONDITION(iter == shared_bridges_.end(), "shared queue is not bound")
+        bridge = std::move(iter->second);
+        shared_bridges_.erase(iter);
+    }
+    return bridge->destroy();
+}
+
+Status ThreadPool::getSharedQueueStats(SharedMemoryQueue* queue, SharedQueueInfo& info){
+    Status status;
+    LOCK_GUARD lock(shared_mutex_);
+    auto iter = shared_bridges_.find(queue);
+    RETURN_ERROR_STATUS_BY_CONDITION(iter == shared_bridges_.end(), "shared queue is not bound")
+    iter->second->snapshot(info);
+    return status;
+}
+
+AsyncIoInfo ThreadPool::getAsyncIoStats(){
+    AsyncIoInfo info;
+    LOCK_GUARD lock(async_io_mutex_);
+    if (async_io_) {
+        async_io_->snapshot(info);
+    }
+    return info;
+}
+
+void ThreadPool::wakeupIdlePrimary(){
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int size = primary_size_.load(std::memory_order_acquire);
+    if (size <= 0 || !idle_mask_.any(size)) {
+        return;             // 没有空闲的主线程，任务会在它们执行完当前任务后被取出
+    }
+    // 起始位置随机，避免总是唤醒同一个线程
+    int begin = (int)(fastRandom() % (unsigned int)size);
+    for (int i = 0; i < size; i++) {
+        auto* pt = primary_threads_[(begin + i) % size];
+        if (pt->parked_.load(std::memory_order_relaxed) && pt->wakeup()) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::pushReactorTask(Task&& task, unsigned int slot, int tag){
+    int size = primary_size_.load(std::memory_order_acquire);
+    if (likely(size > 0)) {
+        primary_threads_[slot % (unsigned int)size]->pushTask(std::move(task.setTrace(TASK_SEGMENT_LOCAL, tag)));
+    } else {
+        task_queue_.push(std::move(task.setTrace(TASK_SEGMENT_POOL, tag)));
+        wakeupIdlePrimary();
+    }
+}
+
 Status ThreadPool::releaseSecondaryThread(int size){
     Status status;
     LOCK_GUARD lock(st_mutex_);
     // 将所有已经结束的，删掉
     for(auto iter = secondary_threads_.begin(); iter != secondary_threads_.end();){
-        !(*iter)->done_? secondary_threads_.erase(iter++) : iter++;
+        if (!(*iter)->done_) {
+            iter = retireSecondaryThread(iter);
+        } else {
+            iter++;
+        }
     }
     RETURN_ERROR_STATUS_BY_CONDITION((size > secondary_threads_.size()), \
                 "cannot release [" + std::to_string(size) + "] secondary thread,"    \
@@ -161,10 +641,12 @@ Status ThreadPool::releaseSecondaryThread(int size){
 
 int ThreadPool::dispatch(int origIndex){
     int realIndex = 0;
-    if(DEFAULT_TASK_STRATEGY == origIndex){
+    if (DEFAULT_TASK_STRATEGY == origIndex && DISPATCH_POLICY_IDLE_FIRST == config_.dispatch_policy_) {
+        realIndex = dispatchIdleFirst();
+    } else if(DEFAULT_TASK_STRATEGY == origIndex){
         /**
-         * 如果是默认策略信息，在[0, default_thread_size_) 之间的，通过 thread 中queue来调度
-         * 在[default_thread_size_, max_thread_size_) 之间的，通过 pool 中的queue来调度
+         * 如果是默认策略信息，在[0, 主线程数量) 之间的，通过 thread 中queue来调度
+         * 在[主线程数量, max_thread_size_) 之间的，通过 pool 中的queue来调度
          */
         realIndex = cur_index_++;
         if(cur_index_ >= config_.max_thread_size_ || cur_index_ < 0){
@@ -176,48 +658,248 @@ int ThreadPool::dispatch(int origIndex){
     return realIndex;         // 交到上游去判断，走哪个线程
 }
 
+int ThreadPool::dispatchIdleFirst(){
+    int size = primary_size_.load(std::memory_order_acquire);
+    if (unlikely(size <= 0)) {
+        return POOL_TASK_STRATEGY;
+    }
+
+    // 优先抢占一个空闲的主线程，起始位置随机，避免多个提交方集中在同一个线程上
+    unsigned int rand = fastRandom();
+    int index = idle_mask_.claim((int)(rand % (unsigned int)size), size);
+    if (index >= 0) {
+        return index;
+    }
+
+    /**
+     * 没有空闲的主线程时，随机选择两个，取本地队列较短的一个（power of two choices）
+     * 正在执行任务的线程，视为多积压了一个任务
+     */
+    int first = (int)(rand % (unsigned int)size);
+    if (1 == size) {
+        return first;
+    }
+    int second = (first + 1 + (int)((rand >> 16) % (unsigned int)(size - 1))) % size;     // 与 first 不同
+    auto load = [this](int i) {
+        auto* pt = primary_threads_[i];
+        return pt->primary_queue_.getApproxSize() + pt->secondary_queue_.getApproxSize()
+               + (pt->is_running_.load(std::memory_order_relaxed) ? 1 : 0);
+    };
+    return load(first) <= load(second) ? first : second;
+}
+
+unsigned int ThreadPool::fastRandom(){
+    // 每个提交线程独立的 xorshift32 状态，无需同步
+    static thread_local unsigned int seed =
+            (unsigned int)std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
 Status ThreadPool::createSecondaryThread(int size){
     Status status;
-    int leftSize = (int)(config_.max_thread_size_- config_.default_thread_size_ - secondary_threads_.size());
+    LOCK_GUARD lock(st_mutex_);
+    int leftSize = (int)(config_.max_thread_size_- primary_size_.load(std::memory_order_acquire) - secondary_threads_.size());
     int realSize = std::min(size, leftSize);
 
-    LOCK_GUARD lock(st_mutex_);
     for(int i = 0; i < realSize; i++){
-        auto ptr = MAKE_UNIQUE_OBJECT(ThreadSecondary)
-        ptr->setThreadPoolInfo(&task_queue_, &priority_task_queue_, &config_);
+        secondary_threads_.emplace_back(buildSecondaryThread(status));
+    }
+
+    return status;
+}
+
+Status ThreadPool::createRealtimeThread(){
+    Status status;
+    if (config_.realtime_thread_size_ <= 0) {
+        return status;
+    }
+
+    const auto& cpus = config_.realtime_thread_cpus_;
+    realtime_threads_.reserve(config_.realtime_thread_size_);
+    for (int i = 0; i < config_.realtime_thread_size_; i++) {
+        // 仅绑定调用方声明的cpu，未声明时不绑定，以普通调度策略运行
+        auto ptr = SAFE_MALLOC_OBJECT(ThreadRealtime);
+        status += ptr->setThreadPoolInfo(i, i < (int)cpus.size() ? cpus[i] : -1, &config_);
         status += ptr->init();
+        realtime_threads_.emplace_back(ptr);
+    }
+    return status;
+}
+
+std::unique_ptr<ThreadSecondary> ThreadPool::buildSecondaryThread(Status& status){
+    auto ptr = MAKE_UNIQUE_OBJECT(ThreadSecondary)
+    ptr->setThreadPoolInfo(&task_queue_, &priority_task_queue_, &fair_task_queue_, &deadline_task_queue_, &primary_threads_, &primary_size_, &config_);
+    ptr->trace_id_ = config_.max_thread_size_ + 1 + secondary_trace_num_++;
+    status += ptr->init();
+    if (trace_) {
+        trace_->recordConcurrent(TraceEventType::SECONDARY_SPAWN, (unsigned int)ptr->trace_id_);
+    }
+    return ptr;
+}
+
+void ThreadPool::reapSecondaryThread(){
+    for (auto iter = secondary_threads_.begin(); iter != secondary_threads_.end(); ) {
+        if (!(*iter)->done_ && (*iter)->exited_.load(std::memory_order_acquire)) {
+            iter = retireSecondaryThread(iter);
+        } else {
+            iter++;
+        }
+    }
+}
+
+ThreadBase* ThreadPool::enterBlocking(){
+    ThreadBase* cur = ThreadBase::current();
+    if (nullptr == cur || cur->config_ != &config_ || cur->blocking_depth_++ > 0) {
+        return nullptr;        // 非本线程池中的线程，或嵌套的区间
+    }
+
+    blocking_num_++;
+    LOCK_GUARD lock(st_mutex_);
+    reapSecondaryThread();
+    int leftSize = (int)(config_.max_thread_size_- primary_size_.load(std::memory_order_acquire) - secondary_threads_.size());
+    if (leftSize > 0) {
+        Status status;
+        auto ptr = buildSecondaryThread(status);
+        ptr->is_compensate_ = true;
         secondary_threads_.emplace_back(std::move(ptr));
+        compensate_num_++;
+        compensate_spawn_num_++;
     }
+    return cur;
+}
 
-    return status;
+void ThreadPool::exitBlocking(ThreadBase* worker){
+    ThreadBase* cur = ThreadBase::current();
+    if (nullptr != cur && cur->config_ == &config_ && cur->blocking_depth_ > 0) {
+        cur->blocking_depth_--;
+    }
+    if (nullptr == worker) {
+        return;
+    }
+
+    blocking_num_--;
+    LOCK_GUARD lock(st_mutex_);
+    if (compensate_num_ <= blocking_num_) {
+        return;                // 补偿线程数量未超出，例如进入区间时已经达到线程数量上限
+    }
+    for (auto& st : secondary_threads_) {
+        if (st->is_compensate_ && st->done_) {
+            st->done_ = false;      // 执行完当前任务后退出，由之后的 reapSecondaryThread() 回收
+            compensate_num_--;
+            break;
+        }
+    }
+}
+
+BlockingScope::BlockingScope(ThreadPool* pool) : pool_(pool) {
+    if (pool_) {
+        worker_ = pool_->enterBlocking();
+    }
+}
+
+BlockingScope::~BlockingScope() {
+    if (pool_) {
+        pool_->exitBlocking(worker_);
+    }
 }
 
 void ThreadPool::monitor(){
-    while(config_.monitor_enable_){
-        while(config_.monitor_enable_ && !is_init_){
-            // 如果没有init，则一直处于空跑状态
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+    unsigned long lastTaskNum = 0;
+    unsigned long lastWaitTime = 0;
+    while (true) {
+        {
+            UNIQUE_LOCK lk(monitor_mutex_);
+            monitor_cv_.wait_for(lk, std::chrono::milliseconds(config_.monitor_interval_),
+                                 [this] { return !config_.monitor_enable_; });
+            if (!config_.monitor_enable_) {
+                break;
+            }
         }
-        
-        auto span = config_.monitor_span_;
-        while(config_.monitor_enable_ && is_init_ && span--){
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        if (is_init_) {
+            // 如果没有init，则一直处于空跑状态
+            autoscale(lastTaskNum, lastWaitTime);
         }
+    }
+}
 
-        // 若 primary线程都在执行，则表示忙碌
-        bool busy = !primary_threads_.empty() && std::all_of(primary_threads_.begin(), primary_threads_.end(),
-                                [](ThreadPrimaryPtr ptr) { return nullptr != ptr && ptr->is_running_; });
+void ThreadPool::autoscale(unsigned long& lastTaskNum, unsigned long& lastWaitTime){
+    auto stats = getStats();
+    auto total = stats.total();
 
-        LOCK_GUARD lock(st_mutex_);
-        if(busy || !priority_task_queue_.empty()){
-            createSecondaryThread(1);
+    /**
+     * 积压数量包含 pool 中的队列和主线程的本地队列
+     * 平均排队耗时，按照本轮新完成的任务计算。辅助线程被回收后累计值会变小，此时本轮不计算
+     */
+    unsigned long backlog = stats.pool_queue_size_ + stats.priority_queue_size_ + total.local_queue_size_;
+    unsigned long taskNum = total.task_num_ > lastTaskNum ? total.task_num_ - lastTaskNum : 0;
+    unsigned long waitTime = total.wait_time_ > lastWaitTime ? total.wait_time_ - lastWaitTime : 0;
+    unsigned long avgWait = taskNum > 0 ? waitTime / taskNum : 0;
+    lastTaskNum = total.task_num_;
+    lastWaitTime = total.wait_time_;
+
+    int threadNum = (int)(stats.primary_threads_.size() + stats.secondary_threads_.size());
+    auto queueLimit = (unsigned long)(config_.autoscale_queue_threshold_ * std::max(threadNum, 1));
+    auto waitLimit = (unsigned long)config_.autoscale_wait_threshold_ * 1000;
+    bool pressure = backlog > queueLimit || avgWait > waitLimit;
+    bool calm = backlog <= queueLimit / 2 && avgWait <= waitLimit / 2;     // 高低水位分开，防止来回抖动
+
+    int pressureTicks = 0;
+    {
+        LOCK_GUARD lock(monitor_mutex_);
+        monitor_info_.tick_num_++;
+        monitor_info_.backlog_ = backlog;
+        monitor_info_.avg_wait_ = avgWait;
+        monitor_info_.pressure_ticks_ = pressure ? monitor_info_.pressure_ticks_ + 1 : 0;
+        pressureTicks = monitor_info_.pressure_ticks_;
+    }
+
+    int addSize = 0;
+    if (pressureTicks >= config_.autoscale_up_ticks_) {
+        // 按照积压数量，估算需要的线程数，单次最多增加 autoscale_max_step_ 个
+        long need = (long)(backlog / config_.autoscale_queue_threshold_) - threadNum;
+        addSize = (int)std::min(std::max(need, 1L), (long)config_.autoscale_max_step_);
+    } else if (stats.secondary_threads_.empty() && stats.priority_queue_size_ > 0) {
+        addSize = 1;        // 长时间任务和优先级任务，仅能由辅助线程执行
+    }
+
+    if (addSize > 0) {
+        createSecondaryThread(addSize);
+        int added = 0;
+        {
+            LOCK_GUARD lock(st_mutex_);
+            added = (int)secondary_threads_.size() - (int)stats.secondary_threads_.size();
+        }
+        LOCK_GUARD lock(monitor_mutex_);
+        monitor_info_.pressure_ticks_ = 0;          // 扩容后重新累计，给新线程留出生效的时间
+        if (added > 0) {
+            monitor_info_.scale_up_num_++;
+            monitor_info_.scale_up_thread_num_ += added;
         }
-        
-        // 判断 secondary 线程是否需要退出
+        return;
+    }
+
+    // 判断 secondary 线程是否需要退出，数量不低于 secondary_thread_size_
+    int released = 0;
+    {
+        LOCK_GUARD lock(st_mutex_);
+        reapSecondaryThread();
         for (auto iter = secondary_threads_.begin(); iter != secondary_threads_.end(); ) {
-            (*iter)->freeze() ? secondary_threads_.erase(iter++) : iter++;
+            if ((int)secondary_threads_.size() > config_.secondary_thread_size_ && (*iter)->freeze(calm)) {
+                iter = retireSecondaryThread(iter);
+                released++;
+            } else {
+                iter++;
+            }
         }
     }
+    if (released > 0) {
+        LOCK_GUARD lock(monitor_mutex_);
+        monitor_info_.scale_down_thread_num_ += released;
+    }
 }
 
-}
\ No newline at end of file
+}
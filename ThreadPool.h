@@ -10,15 +10,49 @@
 #include <vector>
 #include <list>
 #include <map>
+#include <unordered_map>
 #include <future>
 #include <thread>
 #include <algorithm>
 #include <memory>
 #include <functional>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 
 namespace ccy
 { 
-    
+
+class SerialExecutor;
+class Reactor;
+class AsyncIo;
+struct AsyncIoInfo;
+class Fiber;
+class SharedQueueBridge;
+struct SharedQueueInfo;
+class Phaser;
+class ThreadPool;
+
+/**
+ * 阻塞区间，线程池中的线程即将执行阻塞操作（io、sleep、等待锁等）时声明
+ * 构造时立即启动一个补偿线程接替执行任务，析构时通知补偿线程在执行完当前任务后退出
+ * 非本线程池中的线程声明时不做任何处理；嵌套声明时，仅最外层生效
+ */
+class BlockingScope {
+public:
+    explicit BlockingScope(ThreadPool* pool);
+    ~BlockingScope();
+
+    NO_ALLOWED_COPY(BlockingScope)
+
+private:
+    ThreadPool* pool_ = nullptr;
+    ThreadBase* worker_ = nullptr;                                  // 声明区间的线程，仅最外层的区间不为空
+};
+
 class ThreadPool : public ThreadObject {
 public:
     /**
@@ -52,59 +86,231 @@ public:
      * @tparam FunctionType
      * @param func
      * @param index
+     * @param tag 用户自定义标签，用于分类统计延迟信息
      * @return
+     * @notice 开启 auto_route_enable_ 时，默认策略提交的任务会按类型统计执行耗时，耗时较长的类型自动转为长时间任务
      */
     template<typename FunctionType>
-    auto commit(const FunctionType& func, int index = DEFAULT_TASK_STRATEGY)
+    auto commit(const FunctionType& func, int index = DEFAULT_TASK_STRATEGY,
+                int tag = DEFAULT_TASK_TAG)
         -> std::future<decltype(std::declval<FunctionType>()())>
         {
             using RetType = decltype(std::declval<FunctionType>()());
 
-            std::packaged_task<RetType()> task(func);
-            std::future<RetType> result(task.get_future());
+            std::packaged_task<RetType()> packagedTask(func);
+            std::future<RetType> result(packagedTask.get_future());
+            if (config_.auto_route_enable_ && DEFAULT_TASK_STRATEGY == index) {
+                commitProfiled<FunctionType>(std::move(packagedTask), tag);
+                return result;
+            }
+            Task task(std::move(packagedTask));
 
             int realIndex = dispatch(index);
-            if(realIndex >= 0 && realIndex < config_.default_thread_size_){
+            if(realIndex >= 0 && realIndex < primary_size_.load(std::memory_order_acquire)){
                 // 如果返回的结果，在主线程数量之间，则放到主线程的queue中执行
-                primary_threads_[realIndex]->pushTask(std::move(task));
+                primary_threads_[realIndex]->pushTask(std::move(task.setTrace(TASK_SEGMENT_LOCAL, tag)));
             }else if(LONG_TIME_TASK_STRATEGY == realIndex){
                 /**
                  * 如果是长时间任务，则交给特定的任务队列，仅由辅助线程处理
                  * 目的是防止有很多长时间任务，将所有运行的线程均阻塞
                  * 长任务程序，默认优先级较低
                  **/
-                priority_task_queue_.push(std::move(task), LONG_TIME_TASK_STRATEGY);
+                priority_task_queue_.push(std::move(task.setTrace(TASK_SEGMENT_LONG_TIME, tag)), LONG_TIME_TASK_STRATEGY);
             }else{
-                task_queue_.push(std::move(task));
+                task_queue_.push(std::move(task.setTrace(TASK_SEGMENT_POOL, tag)));
+                wakeupIdlePrimary();
             }
             return result;
         }
 
 
+    /**
+     * 提交带类别的任务，不同类别之间按照权重分配执行时间，并受类别的并发上限约束
+     * @tparam FunctionType
+     * @param func
+     * @param taskClass 由 createTaskClass() 创建的类别
+     * @param tag 用户自定义标签，用于分类统计延迟信息
+     * @return
+     * @notice 类别无效时，按照默认策略执行。未指定类别的任务，不参与类别之间的公平调度
+     */
+    template<typename FunctionType>
+    auto commit(const FunctionType& func, const TaskClassHandle& taskClass,
+                int tag = DEFAULT_TASK_TAG)
+    -> std::future<decltype(std::declval<FunctionType>()())> {
+        if (unlikely(!taskClass.isValid())) {
+            return commit(func, DEFAULT_TASK_STRATEGY, tag);
+        }
+
+        using ResultType = decltype(std::declval<FunctionType>()());
+
+        std::packaged_task<ResultType()> packagedTask(func);
+        std::future<ResultType> result(packagedTask.get_future());
+        Task task(std::move(packagedTask));
+        fair_task_queue_.push(taskClass.index_, std::move(task.setTrace(TASK_SEGMENT_FAIR, tag)));
+        wakeupIdlePrimary();
+        return result;
+    }
+
+    /**
+     * 提交带截止时间的任务。所有线程优先执行截止时间最早的任务（EDF），先于主线程的本地队列
+     * @tparam FunctionType
+     * @param deadline 截止时间
+     * @param func
+     * @param missPolicy 开始执行时已经超时的处理方式，参考 DEADLINE_MISS_*
+     * @param onMiss 超时回调，仅 DEADLINE_MISS_CALLBACK 策略生效，在工作线程中执行
+     * @param tag 用户自定义标签，用于分类统计延迟信息
+     * @return
+     * @notice 超时被丢弃（或改为执行回调）的任务，对应 future 的 get() 会抛出 broken_promise
+     */
+    template<typename FunctionType>
+    auto commitBy(std::chrono::steady_clock::time_point deadline, const FunctionType& func,
+                  int missPolicy = DEADLINE_MISS_RUN, DEFAULT_CONST_FUNCTION_REF onMiss = nullptr,
+                  int tag = DEFAULT_TASK_TAG)
+    -> std::future<decltype(std::declval<FunctionType>()())> {
+        using ResultType = decltype(std::declval<FunctionType>()());
+
+        std::packaged_task<ResultType()> packagedTask(func);
+        std::future<ResultType> result(packagedTask.get_future());
+        Task task(std::move(packagedTask));
+
+        // 将截止时间换算成 tick，与任务的入队时间使用同一个时钟
+        auto leftNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+        auto leftTicks = (unsigned long)((double)std::abs(leftNs) / UtilsTicker::nsPerTick());
+        auto now = task.getEnqueueTs();
+        unsigned long deadlineTs = leftNs >= 0 ? now + leftTicks : now - std::min(leftTicks, now);
+        deadline_task_queue_.push(std::move(task.setTrace(TASK_SEGMENT_DEADLINE, tag)),
+                                  deadlineTs, missPolicy, onMiss);
+        wakeupIdlePrimary();
+        return result;
+    }
+
+    /**
+     * 获取带截止时间任务的超时比例和超时耗时
+     * @return
+     */
+    DeadlineTaskInfo getDeadlineStats();
+
     /**
      * 根据优先级，执行任务
      * @tparam FunctionType
      * @param func
-     * @param priority 优先级别。自然序从大到小依次执行
+     * @param priority 优先级别。自然序从大到小依次执行，同一优先级先进先出
+     * @param tag 用户自定义标签，用于分类统计延迟信息
      * @return
-     * @notice priority 范围在 [-100, 100] 之间
+     * @notice priority 范围在 [-100, 100] 之间。默认严格按优先级执行，设置 priority_aging_rate_ 后，排队越久有效优先级越高
      */
     template<typename FunctionType>
-    auto commitWithPriority(const FunctionType& func, int priority)
+    auto commitWithPriority(const FunctionType& func, int priority, int tag = DEFAULT_TASK_TAG)
     -> std::future<decltype(std::declval<FunctionType>()())> {
         using ResultType = decltype(std::declval<FunctionType>()());
 
-        std::packaged_task<ResultType()> task(func);
-        std::future<ResultType> result(task.get_future());
+        std::packaged_task<ResultType()> packagedTask(func);
+        std::future<ResultType> result(packagedTask.get_future());
+        Task task(std::move(packagedTask));
 
         if (secondary_threads_.empty()) {
             createSecondaryThread(1);    // 如果没有开启辅助线程，则直接开启一个
         }
 
-        priority_task_queue_.push(std::move(task), priority);
+        priority_task_queue_.push(std::move(task.setTrace(TASK_SEGMENT_PRIORITY, tag)), priority);
+        return result;
+    }
+
+    /**
+     * 提交到实时线程执行。实时线程持续轮询各自的收件箱，提交后无需唤醒
+     * @tparam FunctionType
+     * @param func
+     * @param tag 用户自定义标签，用于分类统计延迟信息
+     * @return
+     * @notice 未开启 realtime_thread_size_ 时，按照默认策略执行。任务中不宜阻塞，否则会推迟同一实时线程中的后续任务
+     */
+    template<typename FunctionType>
+    auto commitRealtime(const FunctionType& func, int tag = DEFAULT_TASK_TAG)
+    -> std::future<decltype(std::declval<FunctionType>()())> {
+        if (unlikely(realtime_threads_.empty())) {
+            return commit(func, DEFAULT_TASK_STRATEGY, tag);
+        }
+
+        using ResultType = decltype(std::declval<FunctionType>()());
+
+        std::packaged_task<ResultType()> packagedTask(func);
+        std::future<ResultType> result(packagedTask.get_future());
+        Task task(std::move(packagedTask));
+        unsigned int index = realtime_index_.fetch_add(1, std::memory_order_relaxed) % (unsigned int)realtime_threads_.size();
+        realtime_threads_[index]->pushTask(std::move(task.setTrace(TASK_SEGMENT_REALTIME, tag)));
+        return result;
+    }
+
+    /**
+     * 批量提交任务。整批任务写入同一个队列，最多唤醒一个休眠的线程，其余线程由被唤醒方沿窃取关系依次唤醒
+     * @tparam FunctionType
+     * @param funcs
+     * @param tag 用户自定义标签，用于分类统计延迟信息
+     * @return 与 funcs 一一对应的 future
+     * @notice 适合一次性提交大量短任务，相比逐个 commit()，减少了唤醒（futex）的次数
+     */
+    template<typename FunctionType>
+    auto commitBatch(const std::vector<FunctionType>& funcs, int tag = DEFAULT_TASK_TAG)
+    -> std::vector<std::future<decltype(std::declval<FunctionType>()())>> {
+        using ResultType = decltype(std::declval<FunctionType>()());
+
+        std::vector<std::future<ResultType>> results;
+        TaskArr tasks;
+        results.reserve(funcs.size());
+        tasks.reserve(funcs.size());
+        for (const auto& func : funcs) {
+            std::packaged_task<ResultType()> packagedTask(func);
+            results.emplace_back(packagedTask.get_future());
+            tasks.emplace_back(std::move(packagedTask));
+        }
+        pushTasks(tasks, tag);
+        return results;
+    }
+
+    /**
+     * 以协程的方式执行任务。任务中可以调用 Fiber::yield() / Fiber::await() 挂起，挂起期间工作线程继续执行其他任务
+     * @tparam FunctionType
+     * @param func
+     * @param tag 用户自定义标签，用于分类统计延迟信息
+     * @return
+     * @notice 协程栈大小参考 fiber_stack_size_，栈上不宜分配大块内存
+     */
+    template<typename FunctionType>
+    auto commitFiber(const FunctionType& func, int tag = DEFAULT_TASK_TAG)
+    -> std::future<decltype(std::declval<FunctionType>()())> {
+        using ResultType = decltype(std::declval<FunctionType>()());
+
+        std::packaged_task<ResultType()> packagedTask(func);
+        std::future<ResultType> result(packagedTask.get_future());
+        spawnFiber(Task(std::move(packagedTask)), tag);
         return result;
     }
 
+    /**
+     * 提交一轮任务：为 phaser 的每个参与方提交一个任务，任务执行结束后自动到达 phaser，不创建 future
+     * 可以在 phaser 的 onAdvance 中调用，以提交下一轮任务，各轮之间没有线程阻塞等待
+     * @param phaser
+     * @param func 参数为参与方序号
+     * @param tag
+     * @return
+     * @notice phaser 需在全部轮次结束前保持有效。func 抛出异常时仍会到达，异常次数通过 Phaser::getErrorNum() 获取
+     */
+    Status commitPhase(Phaser* phaser, const std::function<void(int party)>& func, int tag = DEFAULT_TASK_TAG);
+
+    /**
+     * 在阻塞区间中执行函数，参考 BlockingScope
+     * @tparam FunctionType
+     * @param func
+     * @return func 的返回值
+     * @notice 补偿线程受 max_thread_size_ 限制，超出时不再补偿
+     */
+    template<typename FunctionType>
+    auto blocking(const FunctionType& func) -> decltype(std::declval<FunctionType>()()) {
+        BlockingScope scope(this);
+        return func();
+    }
+
     /**
      * 执行任务组信息
      * 取taskGroup内部ttl和入参ttl的最小值，为计算ttl标准
@@ -146,6 +352,36 @@ public:
      */
     bool isInit() const;
 
+    /**
+     * 获取当前工作线程的临时内存，可直接作为 std::pmr 容器的 memory_resource
+     * 分配只移动指针、释放不做任何操作，任务（开启 batch_task_enable_ 时为一批任务）结束后统一重置
+     * @return 不在线程池的工作线程中调用时，返回 nullptr
+     * @notice 分配的内存不能在任务结束后继续使用，也不能跨越 Fiber::yield() / Fiber::await()
+     */
+    static ScratchArena* currentArena();
+
+    /**
+     * 获取线程池运行统计信息的快照，不会暂停任何线程
+     * @return
+     */
+    ThreadPoolStats getStats();
+
+    /**
+     * 获取所有线程合并后的任务延迟直方图
+     * @return
+     * @notice 需开启 latency_histogram_enable_，否则返回空的直方图
+     */
+    ThreadLatencyInfo getLatency();
+
+    /**
+     * 将记录的调度事件写成 Chrome trace-event 格式的json文件
+     * 可以在 chrome://tracing 或 ui.perfetto.dev 中打开
+     * @param path
+     * @return
+     * @notice 需开启 trace_enable_，每个线程仅保留最近的 trace_buffer_size_ 个事件
+     */
+    Status dumpTrace(const std::string& path);
+
     /**
      * 生成辅助线程。内部确保辅助线程数量不超过设定参数
      * @param size
@@ -160,7 +396,250 @@ public:
      */
     Status releaseSecondaryThread(int size);
 
+    /**
+     * 运行时调整主线程数量，范围为 [1, max_thread_size_ - 辅助线程数量]
+     * 缩容时从 index 最大的线程开始回收，其本地队列中剩余的任务转移到pool的队列中
+     * @param size
+     * @return
+     * @notice 被回收的线程对象不会释放，扩容时直接复用
+     */
+    Status resizePrimaryThread(int size);
+
+    /**
+     * 获取 key 对应的串行执行器（strand），不存在时创建
+     * 同一个 key 的任务按提交顺序依次执行，不同 key 之间并行执行
+     * @param key
+     * @return
+     * @notice 线程池持有所有执行器的引用，不再使用的 key 需通过 releaseStrand() 释放
+     */
+    std::shared_ptr<SerialExecutor> strand(const std::string& key);
+
+    /**
+     * 释放 key 对应的串行执行器。已提交的任务仍会执行完
+     * @param key
+     * @return
+     */
+    Status releaseStrand(const std::string& key);
+
+    /**
+     * 创建任务类别，同名的类别直接返回已有的句柄
+     * @param name
+     * @param weight 权重，必须大于0。类别之间按照权重比例分配执行时间
+     * @param maxConcurrency 同时执行的任务数量上限，0表示不限制
+     * @return 参数异常时，返回无效的句柄
+     * @notice 类别创建后不会删除，同名类别以第一次创建时的参数为准
+     */
+    TaskClassHandle createTaskClass(const std::string& name,
+                                    int weight = DEFAULT_TASK_CLASS_WEIGHT,
+                                    int maxConcurrency = 0);
+
+    /**
+     * 获取所有任务类别的吞吐和延迟信息
+     * @return
+     * @notice 延迟分位数通过 UtilsHistogramInfo::percentile() 获取，单位为ns
+     */
+    std::vector<TaskClassInfo> getTaskClassStats();
+
+    /**
+     * 获取按可调用类型统计的执行耗时，以及是否被自动转为长时间任务
+     * @return
+     * @notice 需开启 auto_route_enable_
+     */
+    std::vector<TaskProfileInfo> getTaskProfiles();
+
+    /**
+     * 获取当前生效的主线程数量
+     * @return
+     */
+    int getPrimaryThreadSize() const;
+
+    /**
+     * 获取线程池持有的 reactor，用于注册 fd，就绪的回调在主线程中执行
+     * @return
+     * @notice 需开启 reactor_thread_size_，否则返回空
+     */
+    Reactor* getReactor() const;
+
+    /**
+     * 异步读取文件，读取期间不占用工作线程
+     * @param fd
+     * @param offset
+     * @param buf 需保持有效，直到 future 就绪
+     * @param len
+     * @param onFinished 完成回调，在工作线程中执行，参数为读取的字节数或 -errno
+     * @return 读取的字节数，失败时为 -errno。回调返回后才就绪，回调抛出的异常在 get() 时重新抛出
+     * @notice 优先使用 io_uring，不支持时使用 async_io_thread_size_ 个 io 线程，参考 AsyncIo
+     */
+    std::future<long> readAsync(int fd, long offset, void* buf, size_t len,
+                                const std::function<void(long)>& onFinished = nullptr);
+
+    /**
+     * 异步写入文件，参数含义同 readAsync()
+     * @param fd
+     * @param offset
+     * @param buf
+     * @param len
+     * @param onFinished
+     * @return 写入的字节数，失败时为 -errno
+     */
+    std::future<long> writeAsync(int fd, long offset, const void* buf, size_t len,
+                                 const std::function<void(long)>& onFinished = nullptr);
+
+    /**
+     * 消费共享内存队列（可由其他进程写入），取出的任务描述在工作线程中通过 handler 执行
+     * @param queue 需已经 create() 或 open()，生命周期需长于绑定关系
+     * @param handler 执行任务描述的函数，通常按照 func_id_ 分发
+     * @return
+     * @notice 同一个队列仅可绑定一次。多个进程可以同时绑定同一个队列
+     */
+    Status bindSharedQueue(SharedMemoryQueue* queue, const std::function<void(const SharedTaskDesc&)>& handler);
+
+    /**
+     * 解除共享内存队列的绑定，已经取出的任务仍会执行完
+     * @param queue
+     * @return
+     */
+    Status unbindSharedQueue(SharedMemoryQueue* queue);
+
+    /**
+     * 获取共享内存队列绑定关系的统计信息，包括 handler 抛出异常的次数
+     * @param queue
+     * @param info
+     * @return 队列未绑定时，返回错误
+     */
+    Status getSharedQueueStats(SharedMemoryQueue* queue, SharedQueueInfo& info);
+
+    /**
+     * 获取异步 io 的统计信息
+     * @return 尚未使用过异步 io 时，返回空的统计信息
+     */
+    AsyncIoInfo getAsyncIoStats();
+
 protected:
+    /**
+     * 统计执行耗时的提交方式。已经被判定为长时间任务的类型，交给辅助线程执行，否则按默认策略执行
+     * @tparam FunctionType
+     * @tparam RetType
+     * @param packagedTask
+     * @param tag
+     */
+    template<typename FunctionType, typename RetType>
+    void commitProfiled(std::packaged_task<RetType()>&& packagedTask, int tag) {
+        TaskProfile* profile = profiler_.template get<FunctionType>();
+        Task task([this, profile, inner = std::move(packagedTask)]() mutable {
+            auto start = UtilsTicker::now();
+            inner();
+            profiler_.record(profile, UtilsTicker::now() - start);
+        });
+
+        if (profile->isLong()) {
+            if (secondary_threads_.empty()) {
+                createSecondaryThread(1);    // 长时间任务仅由辅助线程执行，确保至少有一个
+            }
+            priority_task_queue_.push(std::move(task.setTrace(TASK_SEGMENT_LONG_TIME, tag)), LONG_TIME_TASK_STRATEGY);
+            return;
+        }
+
+        int realIndex = dispatch(DEFAULT_TASK_STRATEGY);
+        if (realIndex >= 0 && realIndex < primary_size_.load(std::memory_order_acquire)) {
+            primary_threads_[realIndex]->pushTask(std::move(task.setTrace(TASK_SEGMENT_LOCAL, tag)));
+        } else {
+            task_queue_.push(std::move(task.setTrace(TASK_SEGMENT_POOL, tag)));
+            wakeupIdlePrimary();
+        }
+    }
+
+    /**
+     * 向pool中主线程会读取的队列（普通、带截止时间、带类别）写入任务后调用，唤醒一个休眠中的主线程
+     * 与 ThreadPrimary::fatWait() 配合：要么这里看到 parked_ 后唤醒，要么休眠方看到本次写入
+     */
+    void wakeupIdlePrimary();
+
+    /**
+     * 将 reactor 分发的就绪事件写入主线程的本地队列，同一个 slot 固定对应同一个主线程
+     * @param task
+     * @param slot
+     * @param tag
+     */
+    void pushReactorTask(Task&& task, unsigned int slot, int tag);
+
+    /**
+     * 按照默认策略，将一批任务写入同一个队列，最多唤醒一次
+     * @param tasks
+     * @param tag
+     */
+    void pushTasks(TaskArr& tasks, int tag);
+
+    /**
+     * 将异步 io 的完成回调、跨进程的任务等，按照默认策略分发
+     * @param task
+     */
+    void pushCompletionTask(Task&& task);
+
+    /**
+     * 创建协程，并按照默认策略分发
+     * @param body
+     * @param tag
+     */
+    void spawnFiber(Task&& body, int tag);
+
+    /**
+     * 将挂起的协程重新调度。在主线程中调用时，写入该线程的本地队列，否则按照默认策略分发
+     * @param fiber
+     */
+    void scheduleFiber(Fiber* fiber);
+
+    /**
+     * 获取异步 io 的执行器，首次使用时创建
+     * @return 创建失败时返回空
+     */
+    AsyncIo* getAsyncIo();
+
+    /**
+     * 提交异步读写
+     * @param op 参考 ASYNC_IO_*
+     * @param fd
+     * @param offset
+     * @param buf
+     * @param len
+     * @param onFinished
+     * @return
+     */
+    std::future<long> commitAsyncIo(int op, int fd, long offset, void* buf, size_t len,
+                                    const std::function<void(long)>& onFinished);
+
+    /**
+     * 当前线程进入阻塞区间
+     * @return 当前线程为本线程池中的线程、且为最外层区间时，返回该线程，否则返回空
+     */
+    ThreadBase* enterBlocking();
+
+    /**
+     * 线程退出阻塞区间
+     * @param worker enterBlocking() 的返回值
+     */
+    void exitBlocking(ThreadBase* worker);
+
+    /**
+     * 构建一个辅助线程并启动，不加入 secondary_threads_
+     * @param status 启动的结果
+     * @return
+     * @notice 调用方需持有 st_mutex_
+     */
+    std::unique_ptr<ThreadSecondary> buildSecondaryThread(Status& status);
+
+    /**
+     * 创建并启动实时线程。从进程可用的cpu中，由后向前依次绑定，且至少保留一个cpu给其他线程
+     * @return
+     */
+    Status createRealtimeThread();
+
+    /**
+     * 回收线程函数已经返回的辅助线程，无需等待
+     * @notice 调用方需持有 st_mutex_
+     */
+    void reapSecondaryThread();
+
     /**
      * 根据传入的策略信息，确定最终执行方式
      * @param origIndex
@@ -169,24 +648,82 @@ protected:
     virtual int dispatch(int origIndex);
 
     /**
-     * 监控线程执行函数，主要是判断是否需要增加线程，或销毁线程
+     * DISPATCH_POLICY_IDLE_FIRST 策略下，选择执行的主线程
+     * @return
+     */
+    int dispatchIdleFirst();
+
+    /**
+     * 线程内独立的快速随机数
+     * @return
+     */
+    static unsigned int fastRandom();
+
+    /**
+     * 监控线程执行函数，每 monitor_interval_ ms 根据积压任务数量和平均排队耗时，判断是否需要增加线程，或销毁线程
      * 增/删 操作，仅针对secondary类型线程生效
      */
     void monitor();
 
+    /**
+     * 执行一轮扩缩容的判断
+     * @param lastTaskNum 上一轮已完成的任务数量
+     * @param lastWaitTime 上一轮已完成任务的总排队耗时
+     */
+    void autoscale(unsigned long& lastTaskNum, unsigned long& lastWaitTime);
+
+    /**
+     * 回收辅助线程，并保留其调度事件
+     * @param iter
+     * @return 下一个辅助线程
+     * @notice 调用方需持有 st_mutex_
+     */
+    std::list<std::unique_ptr<ThreadSecondary>>::iterator retireSecondaryThread(
+            std::list<std::unique_ptr<ThreadSecondary>>::iterator iter);
+
     NO_ALLOWED_COPY(ThreadPool)
 
+    friend class BlockingScope;
+    friend class Reactor;
+    friend class AsyncIo;
+    friend class Fiber;
+    friend class SharedQueueBridge;
+
 private:
     bool is_init_ { false };                                                       // 是否初始化
     int cur_index_ = 0;                                                            // 记录放入的线程数
     AtomicQueue<Task> task_queue_;                                                // 用于存放普通任务
     AtomicPriorityQueue<Task> priority_task_queue_;                               // 运行时间较长的任务队列，仅在辅助线程中执行
-    std::vector<ThreadPrimaryPtr> primary_threads_;                                // 记录所有的主线程
+    FairTaskQueue fair_task_queue_;                                                // 带类别的任务队列，按权重公平调度
+    TaskProfiler profiler_;                                                         // 按可调用类型统计的执行耗时
+    DeadlineTaskQueue deadline_task_queue_;                                        // 带截止时间的任务队列，按截止时间先后执行
+    std::vector<ThreadPrimaryPtr> primary_threads_;                                // 记录所有的主线程，init后不再变化
+    std::atomic<int> primary_size_ {0};                                             // 当前生效的主线程数量，即 primary_threads_ 的前 n 个
+    std::atomic<int> primary_peak_size_ {0};                                        // 曾经启动过的主线程数量
+    UtilsAtomicBitmap idle_mask_;                                                   // 空闲主线程的位图，由主线程自行维护
+    std::unordered_map<std::string, std::shared_ptr<SerialExecutor>> strands_;      // 所有的串行执行器
+    std::mutex strand_mutex_;                                                       // 保护 strands_
+    std::unique_ptr<Reactor> reactor_;                                              // 基于 epoll 的 reactor，未开启时为空
+    std::unique_ptr<AsyncIo> async_io_;                                             // 异步 io 的执行器，首次使用时创建
+    std::mutex async_io_mutex_;                                                     // 保护 async_io_ 的创建和释放
+    std::map<SharedMemoryQueue*, std::unique_ptr<SharedQueueBridge>> shared_bridges_;  // 绑定的共享内存队列
+    std::mutex shared_mutex_;                                                       // 保护 shared_bridges_
     std::list<std::unique_ptr<ThreadSecondary>> secondary_threads_;                // 记录所有的辅助线程
+    std::vector<ThreadRealtimePtr> realtime_threads_;                               // 记录所有的实时线程，init后不再变化
+    std::atomic<unsigned int> realtime_index_ {0};                                  // 实时任务的轮换分发位置
     ThreadPoolConfig config_;                                                      // 线程池的设置参数
     std::thread monitor_thread_;                                                    // 监控线程
     std::map<size_t, int> thread_record_map_;                                        // 线程记录的信息
     std::mutex st_mutex_;                                                           // 辅助线程发生变动的时候，加的mutex信息
+    std::mutex monitor_mutex_;                                                      // 保护监控线程的退出标记和决策信息
+    std::condition_variable monitor_cv_;                                            // 用于析构时唤醒监控线程
+    ThreadMonitorInfo monitor_info_;                                                // 监控线程的决策信息
+    std::atomic<int> blocking_num_ {0};                                             // 处于阻塞区间的线程数量
+    std::atomic<int> compensate_num_ {0};                                           // 生效中的补偿线程数量，修改时需持有 st_mutex_
+    std::atomic<unsigned long> compensate_spawn_num_ {0};                           // 累计创建的补偿线程数量
+    std::unique_ptr<ThreadTrace> trace_;                                            // pool级别的调度事件（辅助线程的创建和回收）
+    std::list<std::unique_ptr<ThreadTrace>> retired_traces_;                        // 已回收辅助线程的调度事件
+    int secondary_trace_num_ = 0;                                                   // 已分配的辅助线程trace id数量
 };
 
 using ThreadPoolPtr = ThreadPool *;
@@ -5,6 +5,9 @@
 #include "ThreadPoolDefine.h"
 #include "Utils/UtilsDefine.h"
 
+#include <vector>
+#include <sched.h>
+
 namespace ccy
 {
 
@@ -17,18 +20,43 @@ struct ThreadPoolConfig{
     int max_local_batch_size_ = MAX_LOCAL_BATCH_SIZE;
     int max_pool_batch_size_ = MAX_POOL_BATCH_SIZE;
     int max_steal_batch_size_ = MAX_STEAL_BATCH_SIZE;
+    int secondary_steal_policy_ = SECONDARY_STEAL_POLICY;
+    int dispatch_policy_ = DISPATCH_POLICY;
     int primary_thread_busy_epoch_ = PRIMARY_THREAD_BUSY_EPOCH;
     int primary_thread_empty_interval_ = PRIMARY_THREAD_EMPTY_INTERVAL;
+    int idle_strategy_ = IDLE_STRATEGY;
     int secondary_thread_ttl_ = SECONDARY_THREAD_TTL;
-    long monitor_span_ = MONITOR_SPAN;
+    long monitor_interval_ = MONITOR_INTERVAL;
+    long monitor_span_ = 0;                                     // 已废弃，请使用 monitor_interval_。单位为s，大于0时换算后覆盖 monitor_interval_
+    long autoscale_queue_threshold_ = AUTOSCALE_QUEUE_THRESHOLD;
+    long autoscale_wait_threshold_ = AUTOSCALE_WAIT_THRESHOLD;
+    int autoscale_up_ticks_ = AUTOSCALE_UP_TICKS;
+    int autoscale_max_step_ = AUTOSCALE_MAX_STEP;
     long queue_emtpy_interval_ = QUEUE_EMPTY_INTERVAL;
     int primary_thread_policy_ = PRIMARY_THREAD_POLICY;
     int secondary_thread_policy_ = SECONDARY_THREAD_POLICY;
     int primary_thread_priority_ = PRIMARY_THREAD_PRIORITY;
     int secondary_thread_priority_ = SECONDARY_THREAD_PRIORITY;
+    int realtime_thread_size_ = REALTIME_THREAD_SIZE;
+    int realtime_thread_policy_ = REALTIME_THREAD_POLICY;
+    int realtime_thread_priority_ = REALTIME_THREAD_PRIORITY;
+    std::vector<int> realtime_thread_cpus_;                     // 实时线程依次绑定的cpu，需由调用方预先隔离（如 isolcpus），为空时不绑定
     bool bind_cpu_enable_ = BIND_CPU_ENABLE;
     bool batch_task_enable_ = BATCH_TASK_ENABLE;
     bool monitor_enable_ = MONITOR_ENABLE;
+    bool latency_histogram_enable_ = LATENCY_HISTOGRAM_ENABLE;
+    bool trace_enable_ = TRACE_ENABLE;
+    int trace_buffer_size_ = TRACE_BUFFER_SIZE;
+    double priority_aging_rate_ = PRIORITY_AGING_RATE;
+    int priority_aging_cap_ = PRIORITY_AGING_CAP;
+    bool auto_route_enable_ = AUTO_ROUTE_ENABLE;
+    long auto_route_promote_threshold_ = AUTO_ROUTE_PROMOTE_THRESHOLD;
+    long auto_route_demote_threshold_ = AUTO_ROUTE_DEMOTE_THRESHOLD;
+    int reactor_thread_size_ = REACTOR_THREAD_SIZE;
+    bool async_io_uring_enable_ = ASYNC_IO_URING_ENABLE;
+    int async_io_thread_size_ = ASYNC_IO_THREAD_SIZE;
+    int async_io_queue_depth_ = ASYNC_IO_QUEUE_DEPTH;
+    long fiber_stack_size_ = FIBER_STACK_SIZE;
 
     Status check() const {
         Status status;
@@ -40,24 +68,88 @@ struct ThreadPoolConfig{
             RETURN_ERROR_STATUS("max thread size is less than default + secondary thread")
         }
 
-        if (monitor_enable_ && monitor_span_ <= 0) {
-            RETURN_ERROR_STATUS("monitor span cannot less than 0")
+        if (monitor_enable_ && (monitor_interval_ <= 0 || monitor_span_ < 0)) {
+            RETURN_ERROR_STATUS("monitor interval cannot less than 0")
+        }
+
+        if (monitor_enable_ && (autoscale_queue_threshold_ <= 0 || autoscale_wait_threshold_ <= 0
+                                || autoscale_up_ticks_ <= 0 || autoscale_max_step_ <= 0)) {
+            RETURN_ERROR_STATUS("autoscale param cannot less than 0")
+        }
+
+        if (trace_enable_ && trace_buffer_size_ <= 0) {
+            RETURN_ERROR_STATUS("trace buffer size cannot less than 0")
+        }
+
+        if (priority_aging_rate_ < 0 || priority_aging_cap_ < 0) {
+            RETURN_ERROR_STATUS("priority aging param cannot less than 0")
+        }
+
+        if (auto_route_enable_ && (auto_route_demote_threshold_ < 0
+                                   || auto_route_promote_threshold_ < auto_route_demote_threshold_)) {
+            RETURN_ERROR_STATUS("auto route promote threshold cannot less than demote threshold")
+        }
+
+        if (realtime_thread_size_ < 0) {
+            RETURN_ERROR_STATUS("realtime thread size cannot less than 0")
+        }
+
+        if ((int)realtime_thread_cpus_.size() > realtime_thread_size_) {
+            RETURN_ERROR_STATUS("realtime thread cpus is more than realtime thread size")
+        }
+
+        for (int cpu : realtime_thread_cpus_) {
+            if (cpu < 0 || cpu >= CPU_SETSIZE) {
+                RETURN_ERROR_STATUS("realtime thread cpu [" + std::to_string(cpu) + "] is invalid")
+            }
+        }
+
+        if (reactor_thread_size_ < 0) {
+            RETURN_ERROR_STATUS("reactor thread size cannot less than 0")
+        }
+
+        if (async_io_thread_size_ <= 0 || async_io_queue_depth_ <= 0) {
+            RETURN_ERROR_STATUS("async io param cannot less than 1")
+        }
+
+        if (idle_strategy_ < IDLE_STRATEGY_ADAPTIVE || idle_strategy_ > IDLE_STRATEGY_DEEP_SLEEP) {
+            RETURN_ERROR_STATUS("idle strategy is invalid")
+        }
+
+        if (primary_thread_empty_interval_ <= 0) {
+            RETURN_ERROR_STATUS("primary thread empty interval cannot less than 1")
+        }
+
+        if (fiber_stack_size_ < 16 * 1024) {
+            RETURN_ERROR_STATUS("fiber stack size cannot less than 16KB")
         }
         return status;
     }
 
 protected:
     /**
-     * 计算可盗取的范围，盗取范围不能超过默认线程数-1
+     * 兼容已废弃的 monitor_span_：设置后，按秒换算为 monitor_interval_
+     */
+    void convertDeprecated() {
+        if (monitor_span_ > 0) {
+            monitor_interval_ = monitor_span_ * 1000;
+            monitor_span_ = 0;
+        }
+    }
+
+    /**
+     * 计算可盗取的范围，盗取范围不能超过当前主线程数-1
+     * @param primarySize 当前的主线程数量
      * @return
      */
-    int calcStealRange() const {
-        int range = std::min(this->max_task_steal_range_, this->default_thread_size_ - 1);
+    int calcStealRange(int primarySize) const {
+        int range = std::min(this->max_task_steal_range_, primarySize - 1);
         return range;
     }
 
     friend class ThreadPrimary;
     friend class ThreadSecondary;
+    friend class ThreadPool;
 };
 
 
@@ -7,11 +7,13 @@ namespace ccy
 
 static const int CPU_NUM = (int)std::thread::hardware_concurrency();
 static const int THREAD_TYPE_SECONDARY = 2;
+static const int CACHE_LINE_SIZE = 64;                                              // cache line 大小，用于隔离高频写入的数据
 
 static const unsigned int DEFAULT_RINGBUFFER_SIZE = 1024;                           // 默认环形队列的大小
 static const unsigned int DEFAULT_ATOMICRING_SIZE = 1024;                           // 默认环形队列的大小
 static const int SECONDARY_THREAD_COMMON_ID = -1;                                   // 辅助线程统一id标识
 static const int THREAD_TYPE_PRIMARY = 1;
+static const int THREAD_TYPE_REALTIME = 3;
 static const long MAX_BLOCK_TTL = 1999999999;                                       // 最大阻塞时间，单位为ms
 
 static const int THREAD_SCHED_OTHER = SCHED_OTHER;
@@ -29,20 +31,96 @@ static const bool BATCH_TASK_ENABLE = false;
 static const int MAX_LOCAL_BATCH_SIZE = 2;                                           // 批量执行本地任务最大值
 static const int MAX_POOL_BATCH_SIZE = 2;                                            // 批量执行通用任务最大值
 static const int MAX_STEAL_BATCH_SIZE = 2;                                           // 批量盗取任务最大值
-static const int PRIMARY_THREAD_BUSY_EPOCH = 10;                                     // 主线程进入wait状态的轮数，数值越大，理论性能越高，但空转可能性也越大
+static const int PRIMARY_THREAD_BUSY_EPOCH = 10;                                     // 深度休眠策略下，主线程进入wait状态的轮数，数值越大，理论性能越高，但空转可能性也越大
 static const long PRIMARY_THREAD_EMPTY_INTERVAL = 3;                                // 主线程进入休眠状态的默认时间
-static const int SECONDARY_THREAD_TTL = 10;                                          // 辅助线程ttl，单位为s
+static const int SECONDARY_THREAD_TTL = 10;                                          // 辅助线程空闲超过该时间后被回收，单位为s
 static const bool MONITOR_ENABLE = false;                                            // 是否开启监控程序
-static const long MONITOR_SPAN = 5;                                                  // 监控线程执行间隔，单位为s
+static const long MONITOR_INTERVAL = 10;                                             // 监控线程执行间隔，单位为ms
+static const long AUTOSCALE_QUEUE_THRESHOLD = 8;                                     // 平均每个线程积压的任务数量超过该值，视为高负载
+static const long AUTOSCALE_WAIT_THRESHOLD = 2000;                                   // 任务平均排队耗时超过该值，视为高负载，单位为us
+static const int AUTOSCALE_UP_TICKS = 2;                                             // 连续多少轮处于高负载，才开始扩容
+static const int AUTOSCALE_MAX_STEP = 4;                                             // 单次扩容最多增加的辅助线程数量
 static const long QUEUE_EMPTY_INTERVAL = 3;                                         // 队列为空时，等待的时间。仅针对辅助线程，单位为ms
 static const bool BIND_CPU_ENABLE = false;                                           // 是否开启绑定cpu模式（仅针对主线程）
 static const int PRIMARY_THREAD_POLICY = THREAD_SCHED_OTHER;                        // 主线程调度策略
 static const int SECONDARY_THREAD_POLICY = THREAD_SCHED_OTHER;                      // 辅助线程调度策略
 static const int PRIMARY_THREAD_PRIORITY = THREAD_MIN_PRIORITY;                     // 主线程调度优先级
 static const int SECONDARY_THREAD_PRIORITY = THREAD_MIN_PRIORITY;                   // 辅助线程调度优先级（同上）
+static const int REALTIME_THREAD_SIZE = 0;                                           // 实时线程数量，为0时不开启
+static const int REALTIME_THREAD_POLICY = THREAD_SCHED_FIFO;                         // 实时线程调度策略，需要 CAP_SYS_NICE 权限，否则保持普通调度
+static const int REALTIME_THREAD_PRIORITY = 10;                                      // 实时线程调度优先级，不宜过高，避免影响内核线程
+
+static const int DISPATCH_POLICY_ROUND_ROBIN = 0;                                    // 默认策略的任务，依次轮换分发
+static const int DISPATCH_POLICY_IDLE_FIRST = 1;                                     // 默认策略的任务，优先分发给空闲的主线程，否则在随机两个主线程中选择较空闲的
+static const int DISPATCH_POLICY = DISPATCH_POLICY_ROUND_ROBIN;                      // 默认的分发策略
+
+static const int SECONDARY_STEAL_POLICY_NONE = 0;                                    // 辅助线程不从主线程中窃取任务
+static const int SECONDARY_STEAL_POLICY_ROUND_ROBIN = 1;                             // 辅助线程依次轮换起始的主线程
+static const int SECONDARY_STEAL_POLICY_RANDOM = 2;                                  // 辅助线程随机选择起始的主线程
+static const int SECONDARY_STEAL_POLICY_LONGEST_QUEUE = 3;                           // 辅助线程从本地队列最长的主线程中窃取
+static const int SECONDARY_STEAL_POLICY = SECONDARY_STEAL_POLICY_ROUND_ROBIN;        // 辅助线程默认的窃取策略
+
+static const int IDLE_STRATEGY_ADAPTIVE = 0;                                          // 主线程空闲时先自旋再休眠，自旋时长随任务的到达间隔调整
+static const int IDLE_STRATEGY_BUSY_POLL = 1;                                         // 主线程空闲时只退避、不休眠，延迟最低，但持续占用cpu
+static const int IDLE_STRATEGY_DEEP_SLEEP = 2;                                        // 主线程空闲时尽快休眠，且连续空闲时逐步延长休眠时间，适合批处理
+static const int IDLE_STRATEGY = IDLE_STRATEGY_ADAPTIVE;                              // 默认的空闲策略
+static const int IDLE_PAUSE_MAX_SHIFT = 6;                                            // 空转时第n轮 pause 2^n 次，超过该轮数后改为 yield
+static const long IDLE_SPIN_MIN_TIME = 2;                                             // 自适应策略下，休眠前最短的自旋时间（单位us）
+static const long IDLE_SPIN_MAX_TIME = 200;                                           // 自适应策略下，休眠前最长的自旋时间（单位us）。任务的到达间隔超出时，不再延长自旋
+static const long IDLE_DEEP_SLEEP_MAX_INTERVAL = 100;                                 // 深度休眠策略下，单次休眠的最长时间（单位ms）
+
+static const bool LATENCY_HISTOGRAM_ENABLE = false;                                  // 是否开启任务延迟直方图
+static const bool TRACE_ENABLE = false;                                              // 是否开启调度事件记录
+static const int TRACE_BUFFER_SIZE = 65536;                                          // 每个线程保留的事件数量，每个事件16字节
+static const int MAX_RETIRED_TRACE_SIZE = 16;                                        // 保留已回收辅助线程事件的最大数量
+
+static const double PRIORITY_AGING_RATE = 0.0;                                        // 优先级队列中，每排队1ms提升的优先级。默认为0，严格按优先级执行
+static const int PRIORITY_AGING_CAP = 10000;                                          // 优先级队列中，最多提升的优先级。达到上限后，不再追赶更晚入队的任务
+
+static const bool AUTO_ROUTE_ENABLE = false;                                          // 是否根据执行耗时，自动将任务转为长时间任务
+static const long AUTO_ROUTE_PROMOTE_THRESHOLD = 1000;                                // 平均执行耗时超过该值，转为长时间任务（单位us）
+static const long AUTO_ROUTE_DEMOTE_THRESHOLD = 200;                                  // 平均执行耗时低于该值，恢复为普通任务（单位us）
+static const unsigned long AUTO_ROUTE_MIN_SAMPLE = 8;                                 // 统计次数达到该值后，才会切换
+
+static const int DEFAULT_TASK_CLASS_WEIGHT = 1;                                       // 任务类别的默认权重
+static const int DEADLINE_MISS_RUN = 0;                                               // 超时的任务照常执行
+static const int DEADLINE_MISS_DROP = 1;                                              // 超时的任务直接丢弃，对应的 future 返回 broken_promise
+static const int DEADLINE_MISS_CALLBACK = 2;                                          // 超时的任务丢弃，改为执行超时回调
+static const int DEFAULT_STRAND_BATCH_SIZE = 16;                                      // 串行执行器单次调度，最多连续执行的任务数量
+static const int REACTOR_THREAD_SIZE = 0;                                             // reactor 线程数量，为0时不开启 reactor
+static const int REACTOR_MAX_EVENTS = 64;                                             // reactor 单次 epoll_wait 最多返回的事件数量
+static const bool ASYNC_IO_URING_ENABLE = true;                                       // 异步 io 是否优先使用 io_uring
+static const int ASYNC_IO_THREAD_SIZE = 2;                                            // 不支持 io_uring 时，执行异步 io 的线程数量
+static const int ASYNC_IO_QUEUE_DEPTH = 128;                                          // 同时处理中的异步 io 请求数量上限
+static const int ASYNC_IO_READ = 0;                                                   // 异步读
+static const int ASYNC_IO_WRITE = 1;                                                  // 异步写
+static const long FIBER_STACK_SIZE = 256 * 1024;                                      // 协程栈的大小，不含保护页（单位字节）
+static const unsigned int FIBER_STACK_CACHE_SIZE = 16;                                // 每个工作线程缓存的空闲协程栈数量
+static const long FIBER_AWAIT_MIN_INTERVAL = 10;                                      // 主线程检查 await 中协程的最短间隔（单位us）
+static const long FIBER_AWAIT_MAX_INTERVAL = 200;                                     // 检查间隔逐次翻倍的上限（单位us），也是等待期间单次休眠的最长时间
+static const unsigned int SHARED_TASK_PAYLOAD_SIZE = 48;                              // 跨进程任务描述中内联参数的最大长度，使每个槽位恰好占用64字节
+static const unsigned long SHARED_QUEUE_MAGIC = 0x6363795348514D31UL;                 // 共享内存队列的标识，用于校验打开的共享内存
+static const long SHARED_QUEUE_WAIT_INTERVAL = 100;                                   // 共享内存队列为空时，单次休眠的最长时间（单位ms）
+static const int SHARED_QUEUE_DRAIN_BATCH_SIZE = 32;                                  // 从共享内存队列中连续取出的最大数量，之后检查一次退出标记
+static const unsigned long SCRATCH_ARENA_BLOCK_SIZE = 64 * 1024;                      // 工作线程临时内存的默认内存块大小（单位字节）
+static const unsigned long SCRATCH_ARENA_RETAIN_SIZE = 1024 * 1024;                   // 工作线程临时内存重置时保留的内存上限（单位字节），超出部分归还给系统
+static const unsigned int COMBINABLE_CHUNK_SIZE = 64;                                 // 每线程累加对象中，每段存放的线程数量
+static const unsigned int COMBINABLE_CHUNK_NUM = 64;                                  // 每线程累加对象的最大段数，同时存活的线程数不能超过 COMBINABLE_CHUNK_SIZE * COMBINABLE_CHUNK_NUM
+static const int PHASER_TREE_FANOUT = 4;                                              // 阶段屏障中，每个计数器节点负责的参与方（或下层节点）数量
 
 static const int DEFAULT_TASK_STRATEGY = -1;                                         // 默认线程调度策略
 static const int POOL_TASK_STRATEGY = -2;                                            // 固定用pool中的队列的调度策略
 static const int LONG_TIME_TASK_STRATEGY = -101;                                     // 长时间任务调度策略
+
+static const int TASK_SEGMENT_LOCAL = 0;                                             // 任务来自主线程的本地队列（含窃取）
+static const int TASK_SEGMENT_POOL = 1;                                              // 任务来自pool中的普通队列
+static const int TASK_SEGMENT_LONG_TIME = 2;                                         // 长时间任务
+static const int TASK_SEGMENT_PRIORITY = 3;                                          // 带优先级的任务
+static const int TASK_SEGMENT_FAIR = 4;                                              // 带类别的任务，按权重公平调度
+static const int TASK_SEGMENT_DEADLINE = 5;                                          // 带截止时间的任务
+static const int TASK_SEGMENT_REALTIME = 6;                                          // 实时线程执行的任务
+static const int TASK_SEGMENT_SIZE = 7;
+static const int DEFAULT_TASK_TAG = 0;                                               // 默认任务标签
+static const int MAX_TASK_TAG_SIZE = 8;                                              // 延迟直方图支持的标签范围 [0, MAX_TASK_TAG_SIZE)
 }
 #endif
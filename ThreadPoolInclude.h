@@ -8,6 +8,14 @@
 #include "Queue/QueueInclude.h"
 #include "Task/TaskInclude.h"
 #include "Thread/ThreadInclude.h"
+#include "Executor/SerialExecutor.h"
+#include "Executor/SharedQueueBridge.h"
+#include "Reactor/Reactor.h"
+#include "AsyncIo/AsyncIo.h"
+#include "Fiber/Fiber.h"
+#include "Memory/ScratchArena.h"
+#include "Memory/Combinable.h"
+#include "Phaser/Phaser.h"
 // #include "Lock/LockInclude.h"
 // #include "Semaphore/Semaphore.h"
 
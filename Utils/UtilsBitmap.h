@@ -0,0 +1,117 @@
+#ifndef UTILS_BITMAP_H
+#define UTILS_BITMAP_H
+
+#include "UtilsDefine.h"
+
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+namespace ccy
+{
+
+/**
+ * 原子位图，每一位可以被多个线程并发的设置、清除和抢占
+ * 抢占（claim）通过 fetch_and 完成，同一个被置位的bit，只会被一个线程抢占成功
+ */
+class UtilsAtomicBitmap {
+public:
+    explicit UtilsAtomicBitmap(int size = 0) {
+        reset(size);
+    }
+
+    /**
+     * 重新设置大小，并清空所有bit
+     * @param size
+     * @notice 非线程安全，仅在没有并发访问时调用
+     */
+    void reset(int size) {
+        size_ = std::max(size, 0);
+        word_size_ = (size_ + 63) / 64;
+        words_.reset(word_size_ > 0 ? new std::atomic<unsigned long>[word_size_]() : nullptr);
+    }
+
+    void set(int index) {
+        words_[index >> 6].fetch_or(bit(index), std::memory_order_release);
+    }
+
+    void clear(int index) {
+        words_[index >> 6].fetch_and(~bit(index), std::memory_order_relaxed);
+    }
+
+    bool test(int index) const {
+        return 0 != (words_[index >> 6].load(std::memory_order_relaxed) & bit(index));
+    }
+
+    /**
+     * 从 begin 位置开始，在 [0, limit) 范围内查找一个被置位的bit，并将其清除
+     * @param begin 优先选择 begin 及之后的位置，用于分散多个抢占方
+     * @param limit
+     * @return 抢占到的位置，没有则返回-1
+     */
+    int claim(int begin, int limit) {
+        limit = std::min(limit, size_);
+        if (limit <= 0) {
+            return -1;
+        }
+        int limitWords = (limit + 63) / 64;
+        begin = (begin >= 0 && begin < limit) ? begin : 0;
+        int first = begin >> 6;
+        for (int i = 0; i <= limitWords; i++) {
+            // 多遍历一次起始word，处理其中 begin 之前的位置
+            int word = (first + i) % limitWords;
+            unsigned long valid = validMask(word, limit);
+            unsigned long preferred = (0 == i) ? (~0UL << (begin & 63)) : ~0UL;
+            auto& atom = words_[word];
+            unsigned long cur = atom.load(std::memory_order_acquire) & valid;
+            while (0 != cur) {
+                unsigned long candidates = (0 != (cur & preferred)) ? (cur & preferred) : cur;
+                unsigned long target = candidates & (~candidates + 1);     // 最低位的1
+                if (atom.fetch_and(~target, std::memory_order_acq_rel) & target) {
+                    return (word << 6) + __builtin_ctzl(target);
+                }
+                cur = atom.load(std::memory_order_acquire) & valid;        // 被其他线程抢走，重新读取
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * 是否存在被置位的bit
+     * @param limit
+     * @return
+     */
+    bool any(int limit) const {
+        limit = std::min(limit, size_);
+        for (int word = 0; word * 64 < limit; word++) {
+            if (0 != (words_[word].load(std::memory_order_relaxed) & validMask(word, limit))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    NO_ALLOWED_COPY(UtilsAtomicBitmap)
+
+protected:
+    static unsigned long bit(int index) {
+        return 1UL << (index & 63);
+    }
+
+    /**
+     * 第 word 个word中，位于 [0, limit) 范围内的bit
+     */
+    static unsigned long validMask(int word, int limit) {
+        int left = limit - word * 64;
+        return left >= 64 ? ~0UL : ((1UL << left) - 1);
+    }
+
+private:
+    int size_ = 0;
+    int word_size_ = 0;
+    std::unique_ptr<std::atomic<unsigned long>[]> words_;
+};
+
+}
+
+#endif
@@ -0,0 +1,179 @@
+#ifndef UTILS_HISTOGRAM_H
+#define UTILS_HISTOGRAM_H
+
+#include "UtilsDefine.h"
+#include "UtilsTicker.h"
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+namespace ccy
+{
+
+/**
+ * 对数分桶的方式（类似 HdrHistogram）：小于16的值各占一个桶，
+ * 之后每个2的幂次区间再均分为8个子桶，相对误差不超过 12.5%
+ */
+static const int HISTOGRAM_LINEAR_SIZE = 16;
+static const int HISTOGRAM_SUB_BITS = 3;
+static const int HISTOGRAM_SUB_SIZE = 1 << HISTOGRAM_SUB_BITS;
+static const int HISTOGRAM_BUCKET_SIZE = HISTOGRAM_LINEAR_SIZE + (64 - 4) * HISTOGRAM_SUB_SIZE;
+
+
+/**
+ * 直方图的快照，可以合并，记录值的单位为 tick
+ */
+struct UtilsHistogramInfo {
+    std::vector<unsigned long> buckets_ = std::vector<unsigned long>(HISTOGRAM_BUCKET_SIZE, 0);
+    unsigned long count_ = 0;
+    unsigned long sum_ = 0;
+    unsigned long max_ = 0;
+
+    /**
+     * 合并另一个直方图
+     * @param info
+     * @return
+     */
+    UtilsHistogramInfo& merge(const UtilsHistogramInfo& info) {
+        for (int i = 0; i < HISTOGRAM_BUCKET_SIZE; i++) {
+            buckets_[i] += info.buckets_[i];
+        }
+        count_ += info.count_;
+        sum_ += info.sum_;
+        max_ = std::max(max_, info.max_);
+        return *this;
+    }
+
+    /**
+     * 计算分位数，单位为ns
+     * @param percent 取值 [0, 1]
+     * @return
+     */
+    unsigned long percentile(double percent) const {
+        if (0 == count_) {
+            return 0;
+        }
+        auto target = (unsigned long)(std::min(std::max(percent, 0.0), 1.0) * (double)count_);
+        target = std::max(target, 1UL);
+        unsigned long cur = 0;
+        for (int i = 0; i < HISTOGRAM_BUCKET_SIZE; i++) {
+            cur += buckets_[i];
+            if (cur >= target) {
+                return UtilsTicker::toNs(std::min(bucketValue(i), max_));
+            }
+        }
+        return UtilsTicker::toNs(max_);
+    }
+
+    /**
+     * 平均值，单位为ns
+     * @return
+     */
+    unsigned long mean() const {
+        return 0 == count_ ? 0 : UtilsTicker::toNs(sum_ / count_);
+    }
+
+    /**
+     * 最大值，单位为ns
+     * @return
+     */
+    unsigned long max() const {
+        return UtilsTicker::toNs(max_);
+    }
+
+    /**
+     * 桶的代表值（区间中点）
+     * @param index
+     * @return
+     */
+    static unsigned long bucketValue(int index) {
+        if (index < HISTOGRAM_LINEAR_SIZE) {
+            return (unsigned long)index;
+        }
+        int exp = (index - HISTOGRAM_LINEAR_SIZE) / HISTOGRAM_SUB_SIZE + 4;
+        unsigned long sub = (unsigned long)((index - HISTOGRAM_LINEAR_SIZE) % HISTOGRAM_SUB_SIZE);
+        unsigned long width = 1UL << (exp - HISTOGRAM_SUB_BITS);
+        return ((HISTOGRAM_SUB_SIZE + sub) << (exp - HISTOGRAM_SUB_BITS)) + width / 2;
+    }
+};
+
+
+/**
+ * 对数分桶直方图
+ * record() 仅允许单一线程写入（无 read-modify-write 原子操作），recordConcurrent() 可多线程写入
+ * 读取方可以在任意时刻 snapshot()，不需要加锁
+ */
+class UtilsHistogram {
+public:
+    UtilsHistogram() = default;
+
+    /**
+     * 单一线程写入
+     * @param value
+     */
+    void record(unsigned long value) {
+        inc(buckets_[bucketIndex(value)], 1);
+        inc(sum_, value);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * 多线程写入
+     * @param value
+     */
+    void recordConcurrent(unsigned long value) {
+        buckets_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        unsigned long cur = max_.load(std::memory_order_relaxed);
+        while (value > cur && !max_.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+    }
+
+    /**
+     * 合并到快照中
+     * @param info
+     */
+    void snapshot(UtilsHistogramInfo& info) const {
+        unsigned long count = 0;
+        for (int i = 0; i < HISTOGRAM_BUCKET_SIZE; i++) {
+            auto cur = buckets_[i].load(std::memory_order_relaxed);
+            info.buckets_[i] += cur;
+            count += cur;
+        }
+        info.count_ += count;
+        info.sum_ += sum_.load(std::memory_order_relaxed);
+        info.max_ = std::max(info.max_, max_.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * 计算值所在的桶
+     * @param value
+     * @return
+     */
+    static int bucketIndex(unsigned long value) {
+        if (value < (unsigned long)HISTOGRAM_LINEAR_SIZE) {
+            return (int)value;
+        }
+        int exp = 63 - __builtin_clzl(value);
+        int sub = (int)((value >> (exp - HISTOGRAM_SUB_BITS)) & (HISTOGRAM_SUB_SIZE - 1));
+        return HISTOGRAM_LINEAR_SIZE + (exp - 4) * HISTOGRAM_SUB_SIZE + sub;
+    }
+
+    NO_ALLOWED_COPY(UtilsHistogram)
+
+protected:
+    static void inc(std::atomic<unsigned long>& value, unsigned long num) {
+        value.store(value.load(std::memory_order_relaxed) + num, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<unsigned long> buckets_[HISTOGRAM_BUCKET_SIZE] {};
+    std::atomic<unsigned long> sum_ {0};
+    std::atomic<unsigned long> max_ {0};
+};
+
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef UTILS_TICKER_H
+#define UTILS_TICKER_H
+
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace ccy
+{
+
+/**
+ * 低开销的时间戳，x86 上读取 tsc，aarch64 上读取 cntvct，其余平台退化为 steady_clock
+ * 仅用于计算时间差，换算成ns时才需要校准
+ * @notice 依赖 invariant tsc（现代x86均支持），不同核心之间的 tsc 是同步的
+ */
+class UtilsTicker {
+public:
+    /**
+     * 获取当前的 tick 值
+     * @return
+     */
+    static unsigned long now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return (unsigned long)__rdtsc();
+#elif defined(__aarch64__)
+        uint64_t value = 0;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+        return (unsigned long)value;
+#else
+        return steadyNs();
+#endif
+    }
+
+    /**
+     * 将 tick 的差值换算成ns
+     * @param ticks
+     * @return
+     */
+    static unsigned long toNs(unsigned long ticks) {
+        return (unsigned long)((double)ticks * nsPerTick());
+    }
+
+    /**
+     * 每个 tick 对应的ns，首次调用时校准（约10ms），之后直接返回
+     * @return
+     */
+    static double nsPerTick() {
+        static const double ratio = calibrate();
+        return ratio;
+    }
+
+    /**
+     * 忙等时提示 cpu 降低功耗、让出流水线给同核的超线程，不会陷入内核
+     */
+    static void relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#else
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+    }
+
+protected:
+    static unsigned long steadyNs() {
+        return (unsigned long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static double calibrate() {
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+        unsigned long ns = steadyNs();
+        unsigned long ticks = now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        unsigned long spanNs = steadyNs() - ns;
+        unsigned long spanTicks = now() - ticks;
+        return (0 == spanTicks) ? 1.0 : (double)spanNs / (double)spanTicks;
+#else
+        return 1.0;
+#endif
+    }
+};
+
+}
+
+#endif